@@ -0,0 +1,27 @@
+#include <arena.h>
+
+static thread_local RunArena* current_arena = nullptr;
+
+static constexpr size_t kInitialArenaSize = 16 << 10;
+
+RunArena::RunArena(size_t* allocation_counter)
+    : resource_(kInitialArenaSize),
+      allocation_counter_(allocation_counter),
+      previous_(current_arena) {
+    current_arena = this;
+}
+
+RunArena::~RunArena() {
+    Detach();
+}
+
+void RunArena::Detach() {
+    if (is_attached_) {
+        current_arena = previous_;
+        is_attached_ = false;
+    }
+}
+
+RunArena* RunArena::Current() {
+    return current_arena;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+#include <nursery.h>
+#include <ref.h>
+#include <slab.h>
+
+class Cell;
+
+// Bump arena backing the objects created during one Interpreter::Run. From construction until
+// Detach() or destruction it is the current arena of its thread and MakeObject allocates from
+// it; its memory is returned in one go when it is destroyed. Objects allocated from it must not
+// outlive it.
+class RunArena {
+public:
+    // Every allocation served by the arena increments `allocation_counter`, if it is not null.
+    explicit RunArena(size_t* allocation_counter);
+
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    ~RunArena();
+
+    static RunArena* Current();
+
+    // Restores the previous current arena of this thread. The arena memory stays valid, so the
+    // arena can be handed to another thread together with the objects allocated from it.
+    void Detach();
+
+    void* Allocate(size_t size, size_t alignment) {
+        if (allocation_counter_) {
+            ++*allocation_counter_;
+        }
+        return resource_.allocate(size, alignment);
+    }
+
+    template <class T, class... Args>
+    Ref<T> Make(Args&&... args) {
+        T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        object->SetOrigin(RefCounted::Origin::ARENA);
+        return Ref<T>(object);
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource resource_;
+    size_t* allocation_counter_;
+    RunArena* previous_;
+    bool is_attached_ = true;
+};
+
+// Allocates an object from SlabPool (or with new if it is too large for a slab block), whatever
+// arena or nursery is current.
+template <class T, class... Args>
+Ref<T> MakeHeapObject(Args&&... args) {
+    if constexpr (sizeof(T) <= SlabPool::kMaxBlockSize && alignof(T) <= SlabPool::kGranularity) {
+        void* block = SlabPool::Allocate(sizeof(T));
+        T* object;
+        try {
+            object = new (block) T(std::forward<Args>(args)...);
+        } catch (...) {
+            SlabPool::Deallocate(block, sizeof(T));
+            throw;
+        }
+        object->SetOrigin(RefCounted::Origin::SLAB, sizeof(T));
+        return Ref<T>(object);
+    } else {
+        return Ref<T>(new T(std::forward<Args>(args)...));
+    }
+}
+
+// Allocates an object from the current RunArena if there is one, a cell from the current
+// Nursery if there is one, and anything else from the heap (see MakeHeapObject).
+template <class T, class... Args>
+Ref<T> MakeObject(Args&&... args) {
+    if (RunArena* arena = RunArena::Current()) {
+        return arena->Make<T>(std::forward<Args>(args)...);
+    }
+    if constexpr (std::is_same_v<T, Cell>) {
+        if (Nursery* nursery = Nursery::Current()) {
+            return nursery->Make<T>(std::forward<Args>(args)...);
+        }
+    }
+    return MakeHeapObject<T>(std::forward<Args>(args)...);
+}
@@ -0,0 +1,145 @@
+#include <collector.h>
+#include <object.h>
+
+#include <algorithm>
+#include <limits>
+
+static thread_local CycleCollector* current_collector = nullptr;
+
+CycleCollector::CycleCollector(size_t threshold)
+    : threshold_(threshold), previous_(current_collector) {
+    current_collector = this;
+}
+
+CycleCollector::~CycleCollector() {
+    for (Cell* cell : cells_) {
+        cell->collector_ = nullptr;
+    }
+    current_collector = previous_;
+}
+
+CycleCollector* CycleCollector::Current() {
+    return current_collector;
+}
+
+void CycleCollector::Track(Cell* cell) {
+    if (threshold_ > 0 && ++created_since_collection_ >= threshold_) {
+        CollectYoung();
+        if (old_count_ > 2 * std::max(old_count_after_full_, threshold_)) {
+            Collect();
+        }
+    }
+    cell->collector_ = this;
+    cell->collector_slot_ = static_cast<uint32_t>(cells_.size());
+    cells_.push_back(cell);
+}
+
+void CycleCollector::Untrack(Cell* cell) {
+    size_t slot = cell->collector_slot_;
+    // A hole among the old cells is filled with the last old cell, which moves the hole to the
+    // start of the young ones.
+    if (slot < old_count_) {
+        --old_count_;
+        Place(cells_[old_count_], slot);
+        slot = old_count_;
+    }
+    if (slot + 1 != cells_.size()) {
+        Place(cells_.back(), slot);
+    }
+    cells_.pop_back();
+    cell->collector_ = nullptr;
+}
+
+void CycleCollector::Place(Cell* cell, size_t slot) {
+    cell->collector_slot_ = static_cast<uint32_t>(slot);
+    cells_[slot] = cell;
+}
+
+void CycleCollector::Collect() {
+    CollectFrom(0);
+    old_count_after_full_ = old_count_;
+}
+
+void CycleCollector::CollectYoung() {
+    CollectFrom(old_count_);
+    ++stats_.young_collections;
+}
+
+void CycleCollector::CollectFrom(size_t begin) {
+    auto start = std::chrono::steady_clock::now();
+    created_since_collection_ = 0;
+    size_t count = cells_.size() - begin;
+
+    // Index of a child among the collected cells, or `count` if it is not one of them.
+    auto collected_index = [this, begin, count](const Ref<Object>& child) {
+        auto* cell = TryAs<Cell>(child.get());
+        if (!cell || cell->collector_ != this || cell->collector_slot_ < begin) {
+            return count;
+        }
+        return cell->collector_slot_ - begin;
+    };
+
+    // References from outside the collected cells. A cell that is still being constructed has
+    // no owner yet and counts as a root.
+    std::vector<long> outside_refs(count);
+    for (size_t i = 0; i < count; ++i) {
+        long refs = cells_[begin + i]->GetRefCount();
+        outside_refs[i] = refs > 0 ? refs : std::numeric_limits<long>::max();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Cell* cell = cells_[begin + i];
+        for (const auto* child : {&cell->first_, &cell->second_}) {
+            size_t index = collected_index(*child);
+            if (index != count) {
+                --outside_refs[index];
+            }
+        }
+    }
+
+    // Mark everything reachable from the roots.
+    std::vector<bool> marked(count);
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < count; ++i) {
+        if (outside_refs[i] > 0) {
+            marked[i] = true;
+            pending.push_back(i);
+        }
+    }
+    while (!pending.empty()) {
+        Cell* cell = cells_[begin + pending.back()];
+        pending.pop_back();
+        for (const auto* child : {&cell->first_, &cell->second_}) {
+            size_t index = collected_index(*child);
+            if (index != count && !marked[index]) {
+                marked[index] = true;
+                pending.push_back(index);
+            }
+        }
+    }
+
+    // Sweep: hold on to the garbage while cutting its links, then let it go at once.
+    std::vector<Ref<Object>> garbage;
+    for (size_t i = 0; i < count; ++i) {
+        if (!marked[i]) {
+            garbage.emplace_back(cells_[begin + i]);
+        }
+    }
+    for (const auto& object : garbage) {
+        auto& cell = static_cast<Cell&>(*object);
+        cell.first_.reset();
+        cell.second_.reset();
+    }
+    stats_.reclaimed_cells += garbage.size();
+    stats_.reclaimed_bytes += garbage.size() * sizeof(Cell);
+    garbage.clear();
+
+    // Every survivor is old from now on.
+    stats_.promoted_cells += cells_.size() - old_count_;
+    old_count_ = cells_.size();
+
+    auto pause = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+    ++stats_.collections;
+    stats_.total_pause += pause;
+    stats_.max_pause = std::max(stats_.max_pause, pause);
+}
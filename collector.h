@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class Cell;
+
+struct CollectorStats {
+    // All collections, and the young-generation ones among them.
+    size_t collections = 0;
+    size_t young_collections = 0;
+    size_t promoted_cells = 0;
+    size_t reclaimed_cells = 0;
+    size_t reclaimed_bytes = 0;
+    std::chrono::nanoseconds total_pause{0};
+    std::chrono::nanoseconds max_pause{0};
+};
+
+// Tracing collector for the reference cycles that reference counting leaks: cells relinked
+// through SetFirst/SetSecond into a cycle keep each other alive after the last outside reference
+// is gone. From construction until destruction it is the current collector of its thread and
+// tracks every Cell created on that thread.
+//
+// A collection is a mark-sweep over the tracked cells. The roots are the cells referenced from
+// anywhere but another tracked cell (the interpreter's stack, argument vectors, globals, callers
+// of Read...), found by subtracting the references between tracked cells from the reference
+// counts. Cells not reachable from a root only keep each other alive; their links are cut, which
+// frees them. Numbers, symbols and builtins cannot hold references, so they never form cycles.
+//
+// Tracking is generational. New cells are young, and collections triggered by allocation trace
+// only them: a young cell referenced from an old one counts as a root, so no write barrier is
+// needed to find it. Young survivors are promoted to the old generation, which is traced by a
+// full collection once it has doubled in size since the previous one, or on Collect(). Garbage
+// cycles that span both generations therefore wait for a full collection.
+//
+// The generations only bound how much of the heap a collection traces: a collection never moves
+// cells, since code borrows raw pointers into cells across allocations, and it may run on any of
+// them. Allocating young cells together and moving the survivors is left to a Nursery, which is
+// only collected where no such pointers are held.
+//
+// Tracked cells must be released on the collector's thread.
+class CycleCollector {
+public:
+    static constexpr size_t kDefaultThreshold = 100'000;
+
+    // Collects the young generation after every `threshold` tracked cells created; 0 collects
+    // only on Collect() and CollectYoung().
+    explicit CycleCollector(size_t threshold = kDefaultThreshold);
+
+    CycleCollector(const CycleCollector&) = delete;
+    CycleCollector& operator=(const CycleCollector&) = delete;
+
+    // Stops tracking the remaining cells, which stay alive as long as they are referenced.
+    ~CycleCollector();
+
+    static CycleCollector* Current();
+
+    // Full collection of both generations.
+    void Collect();
+
+    void CollectYoung();
+
+    void SetThreshold(size_t threshold) {
+        threshold_ = threshold;
+    }
+
+    size_t GetTrackedCount() const {
+        return cells_.size();
+    }
+
+    size_t GetOldCount() const {
+        return old_count_;
+    }
+
+    const CollectorStats& GetStats() const {
+        return stats_;
+    }
+
+private:
+    friend class Cell;
+
+    void Track(Cell* cell);
+
+    void Untrack(Cell* cell);
+
+    void Place(Cell* cell, size_t slot);
+
+    // Mark-sweep of the cells in slots from `begin` on, with every other cell taken as live.
+    void CollectFrom(size_t begin);
+
+private:
+    // Old cells first, then young ones.
+    std::vector<Cell*> cells_;
+    size_t old_count_ = 0;
+    size_t old_count_after_full_ = 0;
+    size_t threshold_;
+    size_t created_since_collection_ = 0;
+    CollectorStats stats_;
+    CycleCollector* previous_;
+};
@@ -0,0 +1,268 @@
+#include <cons_heap.h>
+
+#include <parser.h>
+
+// Every quoted datum read into a heap shares this marker.
+static const Ref<Object>& QuoteMarker() {
+    static const Ref<Object>* quote = new Ref<Object>(MakePinned<Quote>());
+    return *quote;
+}
+
+ConsHeap::ConsHeap() : car_(1, kNil), cdr_(1, kNil) {
+}
+
+ConsHeap::Value ConsHeap::Cons(Value car, Value cdr) {
+    // A larger index would wrap around and alias another pair.
+    if (GetPairCount() == kMaxPairs) {
+        throw RuntimeError("Cons heap is full");
+    }
+    Value pair = static_cast<Value>(car_.size()) << 2 | kPairTag;
+    car_.push_back(car);
+    cdr_.push_back(cdr);
+    return pair;
+}
+
+ConsHeap::Value ConsHeap::MakeNumber(int value) {
+    if (value < kMinFixnum || value > kMaxFixnum) {
+        return MakeAtom(Number::Make(value));
+    }
+    return static_cast<Value>(value) << 2 | kFixnumTag;
+}
+
+ConsHeap::Value ConsHeap::MakeAtom(const Ref<Object>& atom) {
+    auto [it, inserted] = atom_values_.emplace(atom.get(), 0);
+    if (inserted) {
+        if (atoms_.size() == kMaxAtoms) {
+            atom_values_.erase(it);
+            throw RuntimeError("Cons heap is full");
+        }
+        it->second = static_cast<Value>(atoms_.size()) << 2 | kAtomTag;
+        atoms_.push_back(atom);
+    }
+    return it->second;
+}
+
+// Links the values reported by ReadEvents into pairs as they arrive.
+class ConsHeapBuilder : public DatumHandler {
+public:
+    explicit ConsHeapBuilder(ConsHeap* heap) : heap_(heap) {
+    }
+
+    void OnBeginList() override {
+        frames_.push_back({});
+    }
+
+    void OnEndList() override {
+        Value list = frames_.back().head;
+        frames_.pop_back();
+        Complete(list);
+    }
+
+    void OnDot() override {
+        frames_.back().is_dotted = true;
+    }
+
+    void OnQuote() override {
+        frames_.push_back({.is_quote = true});
+    }
+
+    void OnNumber(int value) override {
+        Complete(heap_->MakeNumber(value));
+    }
+
+    void OnSymbol(std::string_view name) override {
+        Complete(heap_->MakeAtom(SymbolTable::Instantiate().Intern(name)));
+    }
+
+    void OnBoolean(bool value) override {
+        Complete(heap_->MakeAtom(Boolean::Make(value)));
+    }
+
+    ConsHeap::Value GetResult() const {
+        return result_;
+    }
+
+private:
+    using Value = ConsHeap::Value;
+
+    // An unfinished list, or a quote waiting for its datum.
+    struct Frame {
+        Value head = ConsHeap::kNil;
+        Value tail = ConsHeap::kNil;
+        bool is_dotted = false;
+        bool is_quote = false;
+    };
+
+    void Complete(Value value) {
+        while (!frames_.empty() && frames_.back().is_quote) {
+            frames_.pop_back();
+            value = heap_->Cons(heap_->MakeAtom(QuoteMarker()), value);
+        }
+        if (frames_.empty()) {
+            result_ = value;
+            return;
+        }
+        Frame& frame = frames_.back();
+        if (frame.is_dotted) {
+            heap_->SetCdr(frame.tail, value);
+            return;
+        }
+        Value pair = heap_->Cons(value, ConsHeap::kNil);
+        if (frame.head == ConsHeap::kNil) {
+            frame.head = pair;
+        } else {
+            heap_->SetCdr(frame.tail, pair);
+        }
+        frame.tail = pair;
+    }
+
+private:
+    ConsHeap* heap_;
+    std::vector<Frame> frames_;
+    Value result_ = ConsHeap::kNil;
+};
+
+ConsHeap::Value ConsHeap::Read(Tokenizer* tokenizer) {
+    ConsHeapBuilder builder{this};
+    ReadEvents(tokenizer, &builder);
+    return builder.GetResult();
+}
+
+ConsHeap::Value ConsHeap::Import(const Ref<Object>& datum) {
+    if (!Is<Cell>(datum)) {
+        if (!datum) {
+            return kNil;
+        }
+        if (Is<Number>(datum)) {
+            return MakeNumber(Number::GetValue(datum));
+        }
+        return MakeAtom(Is<Quote>(datum) ? QuoteMarker() : datum);
+    }
+    // Walks the cdr chain in a loop, so long lists do not recurse per element.
+    Value head = kNil;
+    Value tail = kNil;
+    const Ref<Object>* rest = &datum;
+    while (Is<Cell>(*rest)) {
+        const Cell& cell = AsRef<Cell>(*rest);
+        Value pair = Cons(Import(cell.GetFirst()), kNil);
+        if (head == kNil) {
+            head = pair;
+        } else {
+            SetCdr(tail, pair);
+        }
+        tail = pair;
+        rest = &cell.GetSecond();
+    }
+    if (*rest) {
+        SetCdr(tail, Import(*rest));
+    }
+    return head;
+}
+
+Ref<Object> ConsHeap::Export(Value value) const {
+    if (!IsPair(value)) {
+        if (value == kNil) {
+            return nullptr;
+        }
+        if ((value & kTagMask) == kFixnumTag) {
+            return Number::Make(static_cast<int32_t>(value) >> 2);
+        }
+        return GetAtom(value);
+    }
+    std::vector<Ref<Object>> elements;
+    for (; IsPair(value); value = Cdr(value)) {
+        elements.push_back(Export(Car(value)));
+    }
+    return MakeCompactList(elements, Export(value));
+}
+
+ConsHeap::Value ConsHeap::ListRef(Value list, size_t index) const {
+    for (size_t i = 0; IsPair(list); ++i, list = Cdr(list)) {
+        if (i == index) {
+            return Car(list);
+        }
+    }
+    throw RuntimeError("Invalid index value");
+}
+
+ConsHeap::Value ConsHeap::ListTail(Value list, size_t index) const {
+    size_t i = 0;
+    for (; IsPair(list); ++i, list = Cdr(list)) {
+        if (i == index) {
+            return list;
+        }
+    }
+    if (i == index) {
+        return list;
+    }
+    throw RuntimeError("Invalid index value");
+}
+
+bool ConsHeap::IsList(Value value) const {
+    while (IsPair(value)) {
+        value = Cdr(value);
+    }
+    return value == kNil;
+}
+
+std::string ConsHeap::ToString(Value value) const {
+    std::string out;
+    if (IsPair(value) || value == kNil) {
+        out += '(';
+        Serialize(value, out);
+        out += ')';
+    } else {
+        Serialize(value, out);
+    }
+    return out;
+}
+
+void ConsHeap::Serialize(Value value, std::string& out) const {
+    // Follows Interpreter::Serialize, including how it brackets nested lists.
+    while (IsPair(value)) {
+        Value first = Car(value);
+        Value second = Cdr(value);
+        if (!IsPair(first) && !IsPair(second) && second != kNil) {
+            SerializeAtom(first, out);
+            out += " . ";
+            SerializeAtom(second, out);
+            return;
+        }
+        if (IsPair(first) || first == kNil) {
+            out += '(';
+            Serialize(first, out);
+            out += ')';
+        } else {
+            SerializeAtom(first, out);
+        }
+        if (second == kNil) {
+            return;
+        }
+        out += ' ';
+        value = second;
+    }
+    SerializeAtom(value, out);
+}
+
+void ConsHeap::SerializeAtom(Value value, std::string& out) const {
+    if (value == kNil) {
+        return;
+    }
+    if ((value & kTagMask) == kFixnumTag) {
+        out += std::to_string(static_cast<int32_t>(value) >> 2);
+        return;
+    }
+    const Ref<Object>& atom = GetAtom(value);
+    if (Is<Number>(atom)) {
+        out += std::to_string(Number::GetValue(atom));
+    } else if (Is<Boolean>(atom)) {
+        out += Boolean::GetValue(atom) ? "#t" : "#f";
+    } else if (Is<Symbol>(atom)) {
+        out += AsRef<Symbol>(atom).GetName();
+    }
+}
+
+size_t ConsHeap::GetMemoryUsage() const {
+    return (car_.capacity() + cdr_.capacity()) * sizeof(Value) +
+           atoms_.capacity() * sizeof(Ref<Object>);
+}
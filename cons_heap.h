@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <object.h>
+#include <tokenizer.h>
+
+// Compact alternative to Cell for large list data. A pair is a 32-bit index into parallel car and
+// cdr arrays whose entries are 32-bit values, so it takes 8 bytes and the pairs of a list read in
+// one go sit next to each other in memory. Values are tagged in their two low bits:
+//   00  a pair, by index; index 0 is the empty list, so the all-zero value is nil;
+//   01  a number in [kMinFixnum, kMaxFixnum], stored inline;
+//   10  an atom: any other object (symbols, booleans, the quote marker, larger numbers), by
+//       index into a table of the atoms used in the heap.
+// Pairs are only freed with the heap, like the objects of a RunArena. The list operations mirror
+// the builtins of the same name and throw the same errors.
+class ConsHeap {
+public:
+    using Value = uint32_t;
+
+    static constexpr Value kNil = 0;
+    static constexpr int kMinFixnum = -(1 << 29);
+    static constexpr int kMaxFixnum = (1 << 29) - 1;
+    // Pair and atom indexes have 30 bits; index 0 is taken by nil among pairs.
+    static constexpr size_t kMaxPairs = (size_t{1} << 30) - 1;
+    static constexpr size_t kMaxAtoms = size_t{1} << 30;
+
+    ConsHeap();
+
+    ConsHeap(const ConsHeap&) = delete;
+    ConsHeap& operator=(const ConsHeap&) = delete;
+
+    static bool IsPair(Value value) {
+        return (value & kTagMask) == kPairTag && value != kNil;
+    }
+
+    // Throws RuntimeError if the heap already holds kMaxPairs pairs.
+    Value Cons(Value car, Value cdr);
+
+    Value Car(Value pair) const {
+        return car_[PairIndex(pair)];
+    }
+
+    Value Cdr(Value pair) const {
+        return cdr_[PairIndex(pair)];
+    }
+
+    void SetCar(Value pair, Value car) {
+        car_[PairIndex(pair)] = car;
+    }
+
+    void SetCdr(Value pair, Value cdr) {
+        cdr_[PairIndex(pair)] = cdr;
+    }
+
+    Value MakeNumber(int value);
+
+    // Any non-cell object; the heap keeps it alive. Throws RuntimeError if the heap already holds
+    // kMaxAtoms other atoms.
+    Value MakeAtom(const Ref<Object>& atom);
+
+    // Reads the next datum from `tokenizer` straight into the heap, without building cells, and
+    // leaves the tokenizer at the token after it. Throws SyntaxError like ReadNext.
+    Value Read(Tokenizer* tokenizer);
+
+    // Copies a datum made of cells into the heap, and back.
+    Value Import(const Ref<Object>& datum);
+    Ref<Object> Export(Value value) const;
+
+    // Element `index` of `list`; throws RuntimeError if there is none.
+    Value ListRef(Value list, size_t index) const;
+
+    // What remains of `list` after `index` elements; throws RuntimeError if it is shorter.
+    Value ListTail(Value list, size_t index) const;
+
+    // Whether `value` is nil or a chain of pairs ending in nil.
+    bool IsList(Value value) const;
+
+    // Same text as Interpreter::PerformOutput on the exported datum.
+    std::string ToString(Value value) const;
+
+    size_t GetPairCount() const {
+        return car_.size() - 1;
+    }
+
+    // Bytes allocated for pairs and atom references, not counting the atoms themselves.
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr Value kTagMask = 3;
+    static constexpr Value kPairTag = 0;
+    static constexpr Value kFixnumTag = 1;
+    static constexpr Value kAtomTag = 2;
+
+    static size_t PairIndex(Value pair) {
+        return pair >> 2;
+    }
+
+    const Ref<Object>& GetAtom(Value value) const {
+        return atoms_[value >> 2];
+    }
+
+    void Serialize(Value value, std::string& out) const;
+
+    void SerializeAtom(Value value, std::string& out) const;
+
+private:
+    // Slot 0 of both arrays is unused, for nil.
+    std::vector<Value> car_;
+    std::vector<Value> cdr_;
+    std::vector<Ref<Object>> atoms_;
+    std::unordered_map<Object*, Value> atom_values_;
+};
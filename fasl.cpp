@@ -0,0 +1,308 @@
+#include <fasl.h>
+
+#include <mapped_file.h>
+#include <parser.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+#include <unistd.h>
+
+static constexpr char kFaslMagic[8] = {'S', 'C', 'M', 'F', 'A', 'S', 'L', '1'};
+
+struct FaslHeader {
+    char magic[8];
+    uint64_t source_hash;
+    uint32_t symbol_count;
+    uint32_t symbol_bytes;
+    uint32_t node_count;
+    uint32_t root_count;
+};
+
+enum FaslKind : uint32_t {
+    kFaslNumber,
+    kFaslBoolean,
+    kFaslSymbol,
+    kFaslQuote,
+    kFaslCell,
+};
+
+// Record 0 is reserved for the empty list, so a child index of 0 means nullptr. A reference with
+// kLastUse set is the last one to its record in load order, so the loader can move the object out.
+static constexpr uint32_t kLastUse = 1u << 31;
+
+struct FaslNode {
+    uint32_t kind;
+    uint32_t first;
+    uint32_t second;
+};
+
+uint64_t HashSource(std::string_view source) {
+    // FNV-1a: stable across builds and platforms, unlike std::hash.
+    uint64_t hash = 14695981039346656037ull;
+    for (char symbol : source) {
+        hash ^= static_cast<unsigned char>(symbol);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Flattens datums into postorder node records, numbering every distinct object once.
+class FaslWriter {
+public:
+    uint32_t Add(const Ref<Object>& root) {
+        // Explicit stack: lists may be millions of cells long.
+        std::vector<std::pair<Object*, bool>> stack{{root.get(), false}};
+        while (!stack.empty()) {
+            auto [object, children_done] = stack.back();
+            stack.pop_back();
+            if (!object || indices_.count(object)) {
+                continue;
+            }
+            auto cell = TryAs<Cell>(object);
+            if (cell && !children_done) {
+                stack.emplace_back(object, true);
+                stack.emplace_back(cell->GetSecond().get(), false);
+                stack.emplace_back(cell->GetFirst().get(), false);
+                continue;
+            }
+            indices_.emplace(object, static_cast<uint32_t>(nodes_.size()));
+            nodes_.push_back(MakeNode(object));
+        }
+        return Index(root.get());
+    }
+
+    void Write(std::ostream& out, uint64_t source_hash, std::vector<uint32_t> roots) {
+        MarkLastUses(roots);
+        FaslHeader header;
+        std::memcpy(header.magic, kFaslMagic, sizeof(kFaslMagic));
+        header.source_hash = source_hash;
+        header.symbol_count = static_cast<uint32_t>(symbols_.size());
+        header.symbol_bytes = static_cast<uint32_t>(symbol_names_.size());
+        header.node_count = static_cast<uint32_t>(nodes_.size());
+        header.root_count = static_cast<uint32_t>(roots.size());
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(symbol_offsets_.data()),
+                  symbol_offsets_.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(nodes_.data()), nodes_.size() * sizeof(FaslNode));
+        out.write(reinterpret_cast<const char*>(roots.data()), roots.size() * sizeof(uint32_t));
+        out.write(symbol_names_.data(), symbol_names_.size());
+    }
+
+private:
+    // Visits references in the order the loader follows them: cells in record order, then roots.
+    void MarkLastUses(std::vector<uint32_t>& roots) {
+        std::vector<uint32_t> last_use(nodes_.size(), 0);
+        std::vector<uint32_t*> references;
+        for (auto& node : nodes_) {
+            if (node.kind == kFaslCell) {
+                references.push_back(&node.first);
+                references.push_back(&node.second);
+            }
+        }
+        for (auto& root : roots) {
+            references.push_back(&root);
+        }
+        for (size_t i = 0; i < references.size(); ++i) {
+            last_use[*references[i]] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = 0; i < references.size(); ++i) {
+            if (*references[i] != 0 && last_use[*references[i]] == i) {
+                *references[i] |= kLastUse;
+            }
+        }
+    }
+
+    uint32_t Index(Object* object) const {
+        return object ? indices_.at(object) : 0;
+    }
+
+    FaslNode MakeNode(Object* object) {
+        if (Is<Number>(object)) {
+            return {kFaslNumber, static_cast<uint32_t>(Number::GetValue(object)), 0};
+        }
+        if (Is<Boolean>(object)) {
+            return {kFaslBoolean, Boolean::GetValue(object), 0};
+        }
+        if (auto symbol = TryAs<Symbol>(object)) {
+            auto [it, inserted] = symbols_.emplace(symbol, symbols_.size());
+            if (inserted) {
+                // symbol_offsets_ holds the end offset of every name.
+                symbol_names_ += symbol->GetName();
+                symbol_offsets_.push_back(static_cast<uint32_t>(symbol_names_.size()));
+            }
+            return {kFaslSymbol, it->second, 0};
+        }
+        if (auto cell = TryAs<Cell>(object)) {
+            return {kFaslCell, Index(cell->GetFirst().get()), Index(cell->GetSecond().get())};
+        }
+        if (TryAs<Quote>(object)) {
+            return {kFaslQuote, 0, 0};
+        }
+        throw std::invalid_argument("fasl: unsupported object");
+    }
+
+    // Placeholder for the reserved record 0.
+    std::vector<FaslNode> nodes_{FaslNode{kFaslCell, 0, 0}};
+    std::unordered_map<Object*, uint32_t> indices_;
+    std::unordered_map<Symbol*, uint32_t> symbols_;
+    std::vector<uint32_t> symbol_offsets_;
+    std::string symbol_names_;
+};
+
+void WriteFasl(const std::string& path, uint64_t source_hash,
+               const std::vector<Ref<Object>>& datums) {
+    FaslWriter writer;
+    std::vector<uint32_t> roots;
+    roots.reserve(datums.size());
+    for (const auto& datum : datums) {
+        roots.push_back(writer.Add(datum));
+    }
+    // Unique to this process and call, so writers caching the same source at once never share a
+    // temporary file; the last rename wins with a complete file.
+    static std::atomic<uint64_t> write_count = 0;
+    std::string temporary_path = path + ".tmp." + std::to_string(getpid()) + "." +
+                                 std::to_string(write_count.fetch_add(1));
+    {
+        std::ofstream out{temporary_path, std::ios::binary | std::ios::trunc};
+        writer.Write(out, source_hash, std::move(roots));
+        if (!out) {
+            int error = errno;
+            std::error_code ignored;
+            std::filesystem::remove(temporary_path, ignored);
+            throw std::system_error(error, std::generic_category(), "cannot write " + path);
+        }
+    }
+    std::filesystem::rename(temporary_path, path);
+}
+
+std::optional<std::vector<Ref<Object>>> LoadFasl(const std::string& path, uint64_t source_hash) {
+    std::optional<MappedFile> file;
+    try {
+        file.emplace(path);
+    } catch (const std::system_error&) {
+        return std::nullopt;
+    }
+    std::string_view data = file->View();
+    FaslHeader header;
+    if (data.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    uint64_t expected_size = sizeof(header) + uint64_t{header.symbol_count} * sizeof(uint32_t) +
+                             uint64_t{header.node_count} * sizeof(FaslNode) +
+                             uint64_t{header.root_count} * sizeof(uint32_t) + header.symbol_bytes;
+    if (std::memcmp(header.magic, kFaslMagic, sizeof(kFaslMagic)) != 0 ||
+        header.source_hash != source_hash || data.size() != expected_size ||
+        header.node_count == 0) {
+        return std::nullopt;
+    }
+    // The sections are read with memcpy: the mapping gives no alignment guarantee past the header.
+    const char* position = data.data() + sizeof(header);
+    auto read_u32 = [](const char* at) {
+        uint32_t value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    };
+    const char* symbol_offsets = position;
+    const char* nodes = symbol_offsets + header.symbol_count * sizeof(uint32_t);
+    const char* roots = nodes + header.node_count * sizeof(FaslNode);
+    std::string_view names{roots + header.root_count * sizeof(uint32_t), header.symbol_bytes};
+
+    std::vector<Ref<Object>> symbols;
+    symbols.reserve(header.symbol_count);
+    uint32_t name_begin = 0;
+    for (uint32_t i = 0; i < header.symbol_count; ++i) {
+        uint32_t name_end = read_u32(symbol_offsets + i * sizeof(uint32_t));
+        if (name_end < name_begin || name_end > names.size()) {
+            return std::nullopt;
+        }
+        symbols.push_back(
+            SymbolTable::Instantiate().Intern(names.substr(name_begin, name_end - name_begin)));
+        name_begin = name_end;
+    }
+
+    std::vector<Ref<Object>> objects(header.node_count);
+    // Whether `reference` names a record before `end` that is loaded and has not been moved out
+    // by an earlier last use. Every record loads as a non-null object, so an empty slot past 0
+    // means the file marked a last use twice.
+    auto is_loaded = [&objects](uint32_t reference, uint32_t end) {
+        uint32_t index = reference & ~kLastUse;
+        return index < end && (index == 0 || objects[index]);
+    };
+    auto take = [&objects](uint32_t reference) {
+        uint32_t index = reference & ~kLastUse;
+        return reference & kLastUse ? std::move(objects[index]) : objects[index];
+    };
+    for (uint32_t i = 1; i < header.node_count; ++i) {
+        FaslNode node;
+        std::memcpy(&node, nodes + i * sizeof(FaslNode), sizeof(node));
+        switch (node.kind) {
+            case kFaslNumber:
+                objects[i] = Number::Make(static_cast<int>(node.first));
+                break;
+            case kFaslBoolean:
+                objects[i] = Boolean::Make(node.first != 0);
+                break;
+            case kFaslSymbol:
+                if (node.first >= symbols.size()) {
+                    return std::nullopt;
+                }
+                objects[i] = symbols[node.first];
+                break;
+            case kFaslQuote:
+                objects[i] = MakeObject<Quote>();
+                break;
+            case kFaslCell: {
+                // Postorder: children always precede their cell. The first child may be the last
+                // use of the second, so each is checked just before it is taken.
+                if (!is_loaded(node.first, i)) {
+                    return std::nullopt;
+                }
+                Ref<Object> first = take(node.first);
+                if (!is_loaded(node.second, i)) {
+                    return std::nullopt;
+                }
+                objects[i] = MakeObject<Cell>(std::move(first), take(node.second));
+                break;
+            }
+            default:
+                return std::nullopt;
+        }
+    }
+
+    std::vector<Ref<Object>> datums;
+    datums.reserve(header.root_count);
+    for (uint32_t i = 0; i < header.root_count; ++i) {
+        uint32_t root = read_u32(roots + i * sizeof(uint32_t));
+        if (!is_loaded(root, header.node_count)) {
+            return std::nullopt;
+        }
+        datums.push_back(take(root));
+    }
+    return datums;
+}
+
+std::vector<Ref<Object>> ReadCached(std::string_view source, const std::string& cache_dir) {
+    uint64_t hash = HashSource(source);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.fasl", static_cast<unsigned long long>(hash));
+    std::string path = (std::filesystem::path{cache_dir} / name).string();
+    if (auto datums = LoadFasl(path, hash)) {
+        return std::move(*datums);
+    }
+    std::vector<Ref<Object>> datums;
+    Tokenizer tokenizer{source};
+    while (!tokenizer.IsEnd()) {
+        datums.push_back(ReadNext(&tokenizer));
+    }
+    std::filesystem::create_directories(cache_dir);
+    WriteFasl(path, hash, datums);
+    return datums;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <object.h>
+
+// Binary cache ("fasl" file) of the datums parsed from a source, keyed by a hash of the source
+// text. The file holds the symbol names followed by fixed-size node records in postorder, each
+// cell referring to its children by record index; loading it maps the file and rebuilds the
+// objects in one linear pass, without the tokenizer or the reader. Shared substructure is stored
+// once and stays shared. Files use the native byte order.
+
+uint64_t HashSource(std::string_view source);
+
+// Writes `datums` to `path`, replacing it atomically.
+void WriteFasl(const std::string& path, uint64_t source_hash,
+               const std::vector<Ref<Object>>& datums);
+
+// Returns nullopt if `path` is missing, was written for another source hash or is malformed.
+std::optional<std::vector<Ref<Object>>> LoadFasl(const std::string& path, uint64_t source_hash);
+
+// Reads every top-level datum of `source`, from its fasl file in `cache_dir` if there is a valid
+// one, and otherwise by parsing `source` and writing the fasl file for the next time.
+std::vector<Ref<Object>> ReadCached(std::string_view source, const std::string& cache_dir);
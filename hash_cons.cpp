@@ -0,0 +1,31 @@
+#include <hash_cons.h>
+
+Ref<Object> HashConsTable::MakeCell(Ref<Object> first, Ref<Object> second) {
+    auto key = std::make_pair(first.get(), second.get());
+    auto it = cells_.find(key);
+    if (it != cells_.end()) {
+        CountShared<Cell>();
+        return it->second;
+    }
+    auto cell = MakeObject<Cell>(std::move(first), std::move(second));
+    cells_.emplace(key, cell);
+    return cell;
+}
+
+Ref<Object> HashConsTable::MakeList(std::vector<Ref<Object>>& elements, Ref<Object> tail) {
+    // Built back to front, so each cell is looked up with its canonical successor.
+    Ref<Object> list = std::move(tail);
+    for (size_t i = elements.size(); i-- > 0;) {
+        list = MakeCell(std::move(elements[i]), std::move(list));
+    }
+    return list;
+}
+
+Ref<Object> HashConsTable::MakeQuote() {
+    if (quote_) {
+        CountShared<Quote>();
+    } else {
+        quote_ = MakeObject<Quote>();
+    }
+    return quote_;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <object.h>
+
+// Canonical copies of immutable quoted data: structurally equal subtrees (same numbers, booleans,
+// symbols and shape) are represented by one shared object graph. The reader builds quoted data
+// through the table bottom-up as each list closes, so a duplicate is found before its cells are
+// allocated and nothing built is ever relinked. Objects are kept alive by the table, so it must
+// not outlive a RunArena that was active while it was filled.
+class HashConsTable {
+public:
+    // The canonical cell holding `first` and `second`, which must be canonical themselves: made
+    // by this table, or atoms other than the quote marker.
+    Ref<Object> MakeCell(Ref<Object> first, Ref<Object> second);
+
+    // The canonical list of `elements`, ended by `tail` if it is not null, all canonical; takes
+    // them out of the vector like MakeCompactList. Its cells are allocated one by one, since a
+    // shared tail may be part of many lists.
+    Ref<Object> MakeList(std::vector<Ref<Object>>& elements, Ref<Object> tail = nullptr);
+
+    // The canonical quote marker.
+    Ref<Object> MakeQuote();
+
+    // Objects that were not allocated because a canonical copy existed, and their memory.
+    size_t GetSharedObjectCount() const {
+        return shared_objects_;
+    }
+
+    size_t GetSavedBytes() const {
+        return saved_bytes_;
+    }
+
+private:
+    struct PairHash {
+        size_t operator()(const std::pair<Object*, Object*>& pair) const {
+            return std::hash<Object*>{}(pair.first) * 31 + std::hash<Object*>{}(pair.second);
+        }
+    };
+
+    template <class T>
+    void CountShared() {
+        ++shared_objects_;
+        saved_bytes_ += sizeof(T);
+    }
+
+    std::unordered_map<std::pair<Object*, Object*>, Ref<Object>, PairHash> cells_;
+    Ref<Object> quote_;
+    size_t shared_objects_ = 0;
+    size_t saved_bytes_ = 0;
+};
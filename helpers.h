@@ -5,20 +5,59 @@
 #include <object.h>
 
 template <typename Obj>
-void GetElems(std::shared_ptr<Obj> tree, std::vector<std::shared_ptr<Obj>> &container);
+void GetElems(Ref<Obj> tree, std::vector<Ref<Obj>> &container);
+
+// An empty argument vector borrowed from a per-thread pool and given back on destruction, so
+// that applying a builtin allocates no vector once the pool has warmed up. Nested applications
+// each borrow their own.
+class PooledFuncArgs {
+public:
+    PooledFuncArgs() {
+        auto &pool = Pool();
+        if (!pool.empty()) {
+            args_ = std::move(pool.back());
+            pool.pop_back();
+        }
+    }
+
+    PooledFuncArgs(const PooledFuncArgs &) = delete;
+    PooledFuncArgs &operator=(const PooledFuncArgs &) = delete;
+
+    ~PooledFuncArgs() {
+        // Vectors grown by a long argument list are not kept around.
+        if (args_.capacity() <= kMaxPooledCapacity) {
+            args_.clear();
+            Pool().push_back(std::move(args_));
+        }
+    }
+
+    FuncArgs &Get() {
+        return args_;
+    }
+
+private:
+    static std::vector<FuncArgs> &Pool() {
+        thread_local std::vector<FuncArgs> pool;
+        return pool;
+    }
+
+    static constexpr size_t kMaxPooledCapacity = 64;
+
+    FuncArgs args_;
+};
 
 template <typename Obj>
-std::shared_ptr<Obj> Unpack(std::shared_ptr<Obj> ast) {
+Ref<Obj> Unpack(Ref<Obj> ast) {
     if (Is<Cell>(ast)) {
-        std::shared_ptr<Obj> first = As<Cell>(ast)->GetFirst();
-        std::shared_ptr<Obj> second = As<Cell>(ast)->GetSecond();
+        Ref<Obj> first = AsRef<Cell>(ast).GetFirst();
+        Ref<Obj> second = AsRef<Cell>(ast).GetSecond();
         if (Is<Symbol>(first)) {
-            std::shared_ptr<Obj> func;
+            Ref<Obj> func;
             func = first->EvalToFunc();
             if (func) {
-                std::vector<std::shared_ptr<Obj>> args;
-                GetElems(second, args);
-                return func->Apply(args);
+                PooledFuncArgs args;
+                GetElems(second, args.Get());
+                return func->Apply(args.Get());
             }
             return ast;
         } else if (Is<Quote>(first)) {
@@ -35,10 +74,10 @@ std::shared_ptr<Obj> Unpack(std::shared_ptr<Obj> ast) {
 }
 
 template <typename Obj>
-void GetElems(std::shared_ptr<Obj> tree, std::vector<std::shared_ptr<Obj>> &container) {
+void GetElems(Ref<Obj> tree, std::vector<Ref<Obj>> &container) {
     if (Is<Cell>(tree)) {
-        std::shared_ptr<Obj> first = As<Cell>(tree)->GetFirst();
-        std::shared_ptr<Obj> second = As<Cell>(tree)->GetSecond();
+        Ref<Obj> first = AsRef<Cell>(tree).GetFirst();
+        Ref<Obj> second = AsRef<Cell>(tree).GetSecond();
         if (!Is<Quote>(first)) {
             container.push_back(first);
         }
@@ -54,14 +93,12 @@ void GetElems(std::shared_ptr<Obj> tree, std::vector<std::shared_ptr<Obj>> &cont
 }
 
 template <typename T, typename Obj>
-bool IsTypes(std::vector<std::shared_ptr<Obj>> &to_check) {
+bool IsTypes(std::vector<Ref<Obj>> &to_check) {
     for (auto &elem : to_check) {
-        std::shared_ptr<Obj> element = elem;
         if (Is<Cell>(elem)) {
             elem = Unpack(elem);
         }
-        auto ptr = std::dynamic_pointer_cast<T>(elem);
-        if (!ptr) {
+        if (!Is<T>(elem)) {
             return false;
         }
     }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file, advised for sequential access. Throws
+// std::system_error if the file cannot be opened or mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    ~MappedFile();
+
+    // Valid while the MappedFile is alive; empty for an empty file.
+    std::string_view View() const {
+        return {data_, size_};
+    }
+
+private:
+    void Unmap();
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
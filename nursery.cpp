@@ -0,0 +1,356 @@
+#include <nursery.h>
+#include <object.h>
+
+#include <algorithm>
+#include <atomic>
+
+static thread_local Nursery* current_nursery = nullptr;
+
+// Header of a chunk, followed by its cell slots. Chunks are aligned to their size, so the chunk
+// of a young cell is found from its address.
+struct Nursery::Chunk {
+    // Null once the chunk has left the nursery.
+    Nursery* owner;
+    // Position in the nursery, while it collects.
+    uint32_t index;
+    // Slots handed out, in order, since the chunk was last emptied.
+    uint32_t used;
+    uint32_t live_cells;
+    // Some of the cells are shared, so they may die on several threads at once.
+    bool is_shared;
+
+    static Chunk* Of(const void* slot) {
+        return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(slot) & ~(kChunkSize - 1));
+    }
+
+    // Which slots hold a live cell; follows the header.
+    bool* GetLiveFlags() {
+        return reinterpret_cast<bool*>(this + 1);
+    }
+
+    Cell* GetCell(size_t slot) const;
+
+    size_t GetSlot(const void* cell) const;
+
+    static const size_t kCellCount;
+    // Of the first cell.
+    static const size_t kCellsOffset;
+};
+
+constexpr size_t Nursery::Chunk::kCellCount =
+    (kChunkSize - sizeof(Chunk) - alignof(Cell)) / (sizeof(Cell) + sizeof(bool));
+constexpr size_t Nursery::Chunk::kCellsOffset =
+    (sizeof(Chunk) + kCellCount * sizeof(bool) + alignof(Cell) - 1) / alignof(Cell) *
+    alignof(Cell);
+
+Cell* Nursery::Chunk::GetCell(size_t slot) const {
+    static_assert(kCellsOffset + kCellCount * sizeof(Cell) <= kChunkSize);
+    auto* cells = reinterpret_cast<const char*>(this) + kCellsOffset;
+    return reinterpret_cast<Cell*>(const_cast<char*>(cells)) + slot;
+}
+
+size_t Nursery::Chunk::GetSlot(const void* cell) const {
+    return (static_cast<const char*>(cell) - reinterpret_cast<const char*>(this) - kCellsOffset) /
+           sizeof(Cell);
+}
+
+static constexpr size_t kMinRememberedLimit = 1024;
+
+static void RemoveDuplicates(std::vector<Ref<Cell>>* cells) {
+    std::sort(cells->begin(), cells->end(),
+              [](const Ref<Cell>& a, const Ref<Cell>& b) { return a.get() < b.get(); });
+    cells->erase(std::unique(cells->begin(), cells->end()), cells->end());
+}
+
+Nursery::Nursery(size_t max_chunks)
+    : max_chunks_(std::max<size_t>(max_chunks, 1)),
+      remembered_limit_(kMinRememberedLimit),
+      previous_(current_nursery) {
+    current_nursery = this;
+}
+
+Nursery::~Nursery() {
+    // Old cells released here may take young ones with them.
+    remembered_.clear();
+    for (Chunk* chunk : chunks_) {
+        chunk->owner = nullptr;
+        if (chunk->live_cells == 0) {
+            ::operator delete(chunk, std::align_val_t{kChunkSize});
+        }
+    }
+    current_nursery = previous_;
+}
+
+Nursery* Nursery::Current() {
+    return current_nursery;
+}
+
+size_t Nursery::GetYoungCount() const {
+    size_t count = 0;
+    for (const Chunk* chunk : chunks_) {
+        count += chunk->live_cells;
+    }
+    return count;
+}
+
+bool Nursery::IsYoung(const Object* object) const {
+    return object && !IsImmediate(object) && object->GetOrigin() == RefCounted::Origin::NURSERY &&
+           Chunk::Of(object)->owner == this;
+}
+
+size_t Nursery::GetSlotId(const Object* cell) const {
+    const Chunk* chunk = Chunk::Of(cell);
+    return chunk->index * Chunk::kCellCount + chunk->GetSlot(cell);
+}
+
+void* Nursery::Allocate() {
+    if (!chunk_ || chunk_->used == Chunk::kCellCount) [[unlikely]] {
+        AddChunk();
+    }
+    uint32_t slot = chunk_->used++;
+    chunk_->GetLiveFlags()[slot] = true;
+    ++chunk_->live_cells;
+    return chunk_->GetCell(slot);
+}
+
+void Nursery::Deallocate(void* slot) {
+    Chunk* chunk = Chunk::Of(slot);
+    uint32_t live_cells = chunk->is_shared
+                              ? std::atomic_ref{chunk->live_cells}.fetch_sub(1) - 1
+                              : --chunk->live_cells;
+    if (chunk->owner) {
+        chunk->GetLiveFlags()[chunk->GetSlot(slot)] = false;
+    } else if (live_cells == 0) {
+        ::operator delete(chunk, std::align_val_t{kChunkSize});
+    }
+}
+
+void Nursery::AddChunk() {
+    // A chunk whose cells have all died is reused, and becomes the youngest.
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        Chunk* chunk = chunks_[i];
+        if (chunk != chunk_ && chunk->live_cells == 0) {
+            chunks_.erase(chunks_.begin() + i);
+            chunks_.push_back(chunk);
+            chunk->used = 0;
+            chunk_ = chunk;
+            return;
+        }
+    }
+    if (chunks_.size() == max_chunks_) {
+        Retire(chunks_.front());
+    }
+    void* block = ::operator new(kChunkSize, std::align_val_t{kChunkSize});
+    chunk_ = new (block) Chunk{this, 0, 0, 0, false};
+    chunks_.push_back(chunk_);
+}
+
+void Nursery::Retire(Chunk* chunk) {
+    chunks_.erase(std::find(chunks_.begin(), chunks_.end(), chunk));
+    if (chunk_ == chunk) {
+        chunk_ = nullptr;
+    }
+    chunk->owner = nullptr;
+    if (chunk->live_cells == 0) {
+        ::operator delete(chunk, std::align_val_t{kChunkSize});
+    }
+}
+
+void Nursery::Evict(const Cell* cell) {
+    Chunk* chunk = Chunk::Of(cell);
+    chunk->is_shared = true;
+    if (chunk->owner) {
+        chunk->owner->Retire(chunk);
+    }
+}
+
+void Nursery::RecordStore(const Cell* cell, const Object* value) {
+    // Arena cells may die with their arena before the next collection, so the young cells they
+    // reference are pinned instead.
+    if (!IsYoung(value) || IsYoung(cell) || cell->GetOrigin() == RefCounted::Origin::ARENA) {
+        return;
+    }
+    if (!remembered_.empty() && remembered_.back().get() == cell) {
+        return;
+    }
+    if (remembered_.size() == remembered_limit_) {
+        RemoveDuplicates(&remembered_);
+        remembered_limit_ = std::max(kMinRememberedLimit, 2 * remembered_.size());
+    }
+    remembered_.emplace_back(const_cast<Cell*>(cell));
+}
+
+void Nursery::Collect() {
+    ++stats_.collections;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        chunks_[i]->index = static_cast<uint32_t>(i);
+    }
+    std::vector<Cell*> young;
+    for (Chunk* chunk : chunks_) {
+        for (uint32_t slot = 0; slot < chunk->used; ++slot) {
+            if (chunk->GetLiveFlags()[slot]) {
+                young.push_back(chunk->GetCell(slot));
+            }
+        }
+    }
+    RemoveDuplicates(&remembered_);
+
+    // References to each young cell from the fields of cells, young or remembered.
+    size_t slot_count = chunks_.size() * Chunk::kCellCount;
+    std::vector<uint32_t> cell_references(slot_count);
+    auto count_children = [&](const Cell* cell) {
+        for (const Ref<Object>* child : {&cell->first_, &cell->second_}) {
+            if (IsYoung(child->get())) {
+                ++cell_references[GetSlotId(child->get())];
+            }
+        }
+    };
+    for (const Cell* cell : young) {
+        count_children(cell);
+    }
+    for (const Ref<Cell>& cell : remembered_) {
+        count_children(cell.get());
+    }
+
+    // Cells with references from outside are pinned; everything reachable from them or from a
+    // remembered cell survives.
+    enum State : uint8_t { UNREACHED, REACHED, PINNED, PROMOTED };
+    std::vector<uint8_t> states(slot_count, UNREACHED);
+    std::vector<Cell*> pending;
+    auto reach_children = [&](const Cell* cell) {
+        for (const Ref<Object>* child : {&cell->first_, &cell->second_}) {
+            if (IsYoung(child->get()) && states[GetSlotId(child->get())] == UNREACHED) {
+                states[GetSlotId(child->get())] = REACHED;
+                pending.push_back(static_cast<Cell*>(child->get()));
+            }
+        }
+    };
+    std::vector<Cell*> pinned;
+    for (Cell* cell : young) {
+        if (cell->GetRefCount() > cell_references[GetSlotId(cell)]) {
+            states[GetSlotId(cell)] = PINNED;
+            pinned.push_back(cell);
+        }
+    }
+    for (const Cell* cell : pinned) {
+        reach_children(cell);
+    }
+    for (const Ref<Cell>& cell : remembered_) {
+        reach_children(cell.get());
+    }
+    std::vector<Cell*> roots = pending;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        reach_children(pending[i]);
+    }
+
+    // Copies the reached cells out, each run of cdrs into one block. A run ends at a cell whose
+    // cdr is not a reached young cell still to promote; the cars are promoted after their run,
+    // in order.
+    std::vector<Cell*> forwards(slot_count);
+    std::vector<Cell*> copies;
+    std::vector<Ref<Object>> promoted;
+    std::vector<Cell*> run;
+    std::vector<Ref<Object>> cars;
+    auto promote = [&](Cell* head) {
+        run.clear();
+        for (Cell* cell = head;;) {
+            states[GetSlotId(cell)] = PROMOTED;
+            run.push_back(cell);
+            Object* next = cell->second_.get();
+            if (!IsYoung(next) || states[GetSlotId(next)] != REACHED) {
+                break;
+            }
+            cell = static_cast<Cell*>(next);
+        }
+        cars.clear();
+        for (Cell* cell : run) {
+            cars.push_back(cell->first_);
+        }
+        Ref<Object> tail = run.back()->second_;
+        Ref<Object> copy = run.size() == 1
+                               ? MakeHeapObject<Cell>(std::move(cars[0]), std::move(tail))
+                               : Cell::MakeSegment(cars, std::move(tail), nullptr);
+        auto* first_copy = static_cast<Cell*>(copy.get());
+        for (size_t i = 0; i < run.size(); ++i) {
+            forwards[GetSlotId(run[i])] = first_copy + i;
+            copies.push_back(first_copy + i);
+        }
+        promoted.push_back(std::move(copy));
+        stats_.promoted_cells += run.size();
+        ++stats_.promoted_runs;
+        for (auto it = run.rbegin(); it != run.rend(); ++it) {
+            Object* car = (*it)->first_.get();
+            if (IsYoung(car) && states[GetSlotId(car)] == REACHED) {
+                pending.push_back(static_cast<Cell*>(car));
+            }
+        }
+    };
+    pending.assign(roots.rbegin(), roots.rend());
+    while (!pending.empty()) {
+        Cell* cell = pending.back();
+        pending.pop_back();
+        if (states[GetSlotId(cell)] == REACHED) {
+            promote(cell);
+        }
+    }
+
+    // Held until they are unlinked: the promoted cells start dying as soon as the fields that
+    // referenced them point at their copies.
+    std::vector<Ref<Object>> dead;
+    for (Cell* cell : young) {
+        uint8_t state = states[GetSlotId(cell)];
+        if (state == UNREACHED) {
+            ++stats_.reclaimed_cells;
+        }
+        if (state != PINNED) {
+            dead.emplace_back(cell);
+        }
+    }
+
+    // Points every field that referenced a promoted cell at its copy.
+    auto forward = [&](Cell* cell) {
+        for (Ref<Object>* child : {&cell->first_, &cell->second_}) {
+            if (IsYoung(child->get())) {
+                if (Cell* copy = forwards[GetSlotId(child->get())]) {
+                    *child = Ref<Object>(copy);
+                }
+            }
+        }
+    };
+    for (Cell* cell : copies) {
+        forward(cell);
+    }
+    for (Cell* cell : pinned) {
+        forward(cell);
+    }
+    for (const Ref<Cell>& cell : remembered_) {
+        forward(cell.get());
+    }
+    promoted.clear();
+    remembered_.clear();
+    remembered_limit_ = kMinRememberedLimit;
+
+    // The promoted cells are now referenced only by each other and by unreached cells, which
+    // are garbage: unlinking them all frees them.
+    for (const Ref<Object>& cell : dead) {
+        static_cast<Cell*>(cell.get())->first_.reset();
+        static_cast<Cell*>(cell.get())->second_.reset();
+    }
+    dead.clear();
+    if (!copies.empty()) {
+        // List cursors may lie in the cells that moved.
+        Cell::DropListCursors();
+    }
+
+    // Chunks with pinned cells leave the nursery with them; the others are emptied.
+    stats_.pinned_cells += pinned.size();
+    chunk_ = nullptr;
+    for (Chunk* chunk : std::vector<Chunk*>(chunks_)) {
+        if (chunk->live_cells > 0) {
+            Retire(chunk);
+        } else {
+            chunk->used = 0;
+            chunk_ = chunk_ ? chunk_ : chunk;
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <ref.h>
+
+class Cell;
+class Object;
+
+struct NurseryStats {
+    size_t collections = 0;
+    // Young cells copied out to the old space, and the blocks they were copied into: a run of
+    // cells linked by their cdrs is copied into one segment (see MakeCompactList).
+    size_t promoted_cells = 0;
+    size_t promoted_runs = 0;
+    // Young cells left where they are because something other than a cell references them.
+    size_t pinned_cells = 0;
+    // Young cells that only kept each other alive.
+    size_t reclaimed_cells = 0;
+};
+
+// Young generation for cells. From construction until destruction it is the current nursery of
+// its thread, and MakeObject<Cell> takes cells from it with a pointer bump into 64 KiB chunks
+// (unless a RunArena is current, which comes first). Cells that die free their slot only; a
+// chunk whose cells are all dead is reused whole.
+//
+// Collect() promotes the survivors to the old space, which MakeObject serves when no nursery is
+// current. A young cell referenced only from cells is copied out, and the fields referencing it
+// are pointed at the copy; the copies are laid out cdr first, so a list of young cells comes out
+// as one segment that the list functions jump through. A young cell referenced from anywhere
+// else (a Ref on the stack, a vector, a hash table) cannot be found and updated, so it is
+// pinned: it stays where it is, and its chunk leaves the nursery until its last cell dies. The
+// references are told apart by subtracting the references between cells from the counts, as the
+// CycleCollector does. Young cells reachable neither from outside the nursery nor from a pinned
+// cell only keep each other alive, and are freed.
+//
+// The old cells referencing young ones are recorded by a write barrier in Cell::SetFirst and
+// SetSecond, and when a compact list is built around young cells. A store the barrier misses
+// (one made while another nursery is current, say) only pins the cell stored.
+//
+// Collect() moves cells, so it must be called where no raw pointer or C++ reference into a young
+// cell is held, such as between two Runs; Refs are fine. Overflowing the nursery moves nothing:
+// once it holds `max_chunks` chunks, the oldest one that still holds cells leaves it with them.
+//
+// Young cells must be released on the nursery's thread; sharing one (see ShareAcrossThreads)
+// takes its chunk out of the nursery first.
+class Nursery {
+public:
+    static constexpr size_t kChunkSize = 64 << 10;
+    static constexpr size_t kDefaultMaxChunks = 64;
+
+    explicit Nursery(size_t max_chunks = kDefaultMaxChunks);
+
+    Nursery(const Nursery&) = delete;
+    Nursery& operator=(const Nursery&) = delete;
+
+    // Leaves the remaining young cells where they are, alive as long as they are referenced.
+    ~Nursery();
+
+    static Nursery* Current();
+
+    void Collect();
+
+    // Live cells in the chunks of the nursery.
+    size_t GetYoungCount() const;
+
+    const NurseryStats& GetStats() const {
+        return stats_;
+    }
+
+    // Whether `object` is a young cell of this nursery.
+    bool IsYoung(const Object* object) const;
+
+    template <class T, class... Args>
+    Ref<T> Make(Args&&... args) {
+        void* slot = Allocate();
+        T* object;
+        try {
+            object = new (slot) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Deallocate(slot);
+            throw;
+        }
+        object->SetOrigin(RefCounted::Origin::NURSERY);
+        return Ref<T>(object);
+    }
+
+    // Gives the slot of a dead young cell back.
+    static void Deallocate(void* slot);
+
+    // Takes the chunk of the young cell `cell` out of its nursery, for good, before the cell is
+    // shared with other threads.
+    static void Evict(const Cell* cell);
+
+private:
+    friend class Cell;
+
+    struct Chunk;
+
+    void* Allocate();
+
+    void AddChunk();
+
+    // Takes `chunk` out of the nursery; it is freed with its last cell.
+    void Retire(Chunk* chunk);
+
+    // Write barrier: `cell` now references `value`.
+    void RecordStore(const Cell* cell, const Object* value);
+
+    size_t GetSlotId(const Object* cell) const;
+
+private:
+    // Oldest first.
+    std::vector<Chunk*> chunks_;
+    // The chunk cells are allocated from.
+    Chunk* chunk_ = nullptr;
+    size_t max_chunks_;
+    // Old cells that may reference young ones, possibly several times over.
+    std::vector<Ref<Cell>> remembered_;
+    size_t remembered_limit_;
+    NurseryStats stats_;
+    Nursery* previous_;
+};
@@ -1,52 +1,408 @@
 #include <object.h>
+#include <collector.h>
 #include <helpers.h>
+#include <nursery.h>
 
-std::shared_ptr<Object> Number::EvalToFunc() {
-    throw RuntimeError("Number cannot be evaluated to function");
+const std::string& Symbol::GetName() const {
+    return name_;
 }
-int Number::GetValue() const {
-    return value_;
+
+size_t Symbol::GetId() const {
+    return id_;
 }
 
-bool Boolean::GetValue() const {
-    return value_;
+Ref<Object> Symbol::EvalToFunc() {
+    return OperationsMap::Instantiate().GetOperation(id_);
 }
 
-const std::string& Symbol::GetName() const {
-    return name_;
+Ref<Symbol> SymbolTable::Intern(std::string_view name) {
+    Shard& shard = shards_[NameHash{}(name) % kShardCount];
+    std::lock_guard lock{shard.mutex};
+    auto it = shard.ids.find(name);
+    if (it != shard.ids.end()) {
+        return it->second;
+    }
+    size_t id = size_.fetch_add(1, std::memory_order_relaxed);
+    auto* symbol = new Symbol(std::string(name), id);
+    // Symbols are referenced from every thread and never die.
+    symbol->Pin();
+    shard.ids.emplace(symbol->GetName(), symbol);
+    return Ref<Symbol>(symbol);
+}
+
+OperationsMap::OperationsMap() {
+    Bind("+", MakePinned<Calculate<PlusFunc>>());
+    Bind("-", MakePinned<Calculate<MinusFunc>>());
+    Bind("*", MakePinned<Calculate<MultFunc>>());
+    Bind("/", MakePinned<Calculate<DivFunc>>());
+    Bind("max", MakePinned<Calculate<MaxFunc>>());
+    Bind("min", MakePinned<Calculate<MinFunc>>());
+    Bind("abs", MakePinned<Absolute>());
+    Bind("or", MakePinned<Or>());
+    Bind("and", MakePinned<And>());
+    Bind("not", MakePinned<Not>());
+    Bind("boolean?", MakePinned<Predicate<Boolean>>());
+    Bind("number?", MakePinned<Predicate<Number>>());
+    Bind("null?", MakePinned<ListPredicate<NullFunc>>());
+    Bind("pair?", MakePinned<ListPredicate<PairFunc>>());
+    Bind("list?", MakePinned<ListPredicate<ListFunc>>());
+    Bind("=", MakePinned<Monotony<EqualFunc>>());
+    Bind(">", MakePinned<Monotony<GreaterFunc>>());
+    Bind("<", MakePinned<Monotony<LessFunc>>());
+    Bind("<=", MakePinned<Monotony<LessEqualFunc>>());
+    Bind(">=", MakePinned<Monotony<GreaterEqualFunc>>());
+    Bind("quote", MakePinned<Quote>());
+    Bind("cons", MakePinned<Cons>());
+    Bind("car", MakePinned<Car>());
+    Bind("cdr", MakePinned<Cdr>());
+    Bind("list-ref", MakePinned<ListRef>());
+    Bind("list-tail", MakePinned<ListTail>());
+    Bind("length", MakePinned<Length>());
+    Bind("list", MakePinned<MakeList>());
+}
+
+void OperationsMap::Bind(std::string_view name, Ref<Object> operation) {
+    size_t id = SymbolTable::Instantiate().Intern(name)->GetId();
+    if (operations_.size() <= id) {
+        operations_.resize(id + 1);
+    }
+    operations_[id] = std::move(operation);
+}
+
+// Marks the `first_` of a deferred cell; never visible outside Cell.
+static const Ref<Object> kDeferredMarker = MakePinned<Object>();
+
+Cell::Cell(Ref<Object> first, Ref<Object> second)
+    : Object(ObjectKind::CELL), first_(std::move(first)), second_(std::move(second)) {
+    if (CycleCollector* collector = CycleCollector::Current()) {
+        collector->Track(this);
+    }
+}
+
+Cell::Cell(Ref<DeferredList> list)
+    : Object(ObjectKind::CELL), first_(kDeferredMarker), second_(std::move(list)) {
+    if (CycleCollector* collector = CycleCollector::Current()) {
+        collector->Track(this);
+    }
+}
+
+bool Cell::IsDeferred() const {
+    return first_.get() == kDeferredMarker.get();
 }
 
-std::shared_ptr<Object> Symbol::EvalToFunc() {
-    auto& map = OperationsMap::Instantiate();
-    if (!map.CheckExistence(name_)) {
-        return nullptr;
+void Cell::ReadDeferred() const {
+    auto list = StaticRefCast<Cell>(static_cast<DeferredList&>(*second_).Read());
+    // The list is read eagerly at its top, so its halves are final.
+    first_ = std::move(list->first_);
+    second_ = std::move(list->second_);
+}
+
+void Cell::Untrack() {
+    if (collector_) {
+        collector_->Untrack(this);
+    }
+}
+
+Cell::~Cell() {
+    Untrack();
+    // Uniquely owned child cells are unlinked onto a worklist before they die, so their own
+    // destructors find nothing left to release.
+    std::vector<Ref<Object>> pending;
+    auto release = [&pending](Ref<Object>& child) {
+        if (Is<Cell>(child) && child.use_count() == 1) {
+            pending.push_back(std::move(child));
+        }
+    };
+    release(first_);
+    release(second_);
+    while (!pending.empty()) {
+        Ref<Object> cell = std::move(pending.back());
+        pending.pop_back();
+        release(static_cast<Cell*>(cell.get())->first_);
+        release(static_cast<Cell*>(cell.get())->second_);
     }
-    return map.GetOperation(name_);
 }
 
-std::shared_ptr<Object> Cell::GetFirst() const {
+const Ref<Object>& Cell::GetFirst() const {
+    if (IsDeferred()) {
+        ReadDeferred();
+    }
     return first_;
 }
-std::shared_ptr<Object> Cell::GetSecond() const {
+const Ref<Object>& Cell::GetSecond() const {
+    if (IsDeferred()) {
+        ReadDeferred();
+    }
     return second_;
 }
 
-void Cell::SetFirst(std::shared_ptr<Object> other_first) {
+void Cell::SetFirst(Ref<Object> other_first) {
+    if (IsDeferred()) {
+        ReadDeferred();
+    }
+    if (Nursery* nursery = Nursery::Current()) {
+        nursery->RecordStore(this, other_first.get());
+    }
     first_ = other_first;
 }
 
-void Cell::SetSecond(std::shared_ptr<Object> other_second) {
+// Counts the SetSecond calls, on any thread, that changed a link a list walk had followed, so
+// that a list cursor can tell whether the cells it passed still form the same chain. Links no
+// walk has followed yet, such as those of lists under construction, are changed for free.
+static std::atomic<uint64_t> list_relinks = 0;
+
+// The list stamp of a cell (see Cell::GetListStamp) is 0 until a list walk passes it, then
+// kPassedStamp, or a stamp from NewListStamp once it heads a cursor. The stamp of a segment is
+// always a new one.
+static constexpr uint32_t kPassedStamp = 1;
+
+// Stamps issued so far; the stamps are its low 32 bits.
+static std::atomic<uint64_t> list_stamps = 0;
+
+static uint32_t NewListStamp() {
+    while (true) {
+        auto stamp = static_cast<uint32_t>(list_stamps.fetch_add(1, std::memory_order_relaxed) + 1);
+        if (stamp == 0) {
+            // The stamps wrap around, so a stamp may come back on a new cell at the address of a
+            // cursor's head: every cursor made so far is dropped.
+            list_relinks.fetch_add(1);
+        }
+        if (stamp > kPassedStamp) {
+            return stamp;
+        }
+    }
+}
+
+// Whether `stamp` was issued since the stamps last wrapped around. An older one may come back on
+// another cell before they wrap again.
+static bool IsCurrentListStamp(uint32_t stamp) {
+    return stamp <= static_cast<uint32_t>(list_stamps.load(std::memory_order_relaxed));
+}
+
+void Cell::SetSecond(Ref<Object> other_second) {
+    if (IsDeferred()) {
+        ReadDeferred();
+    }
+    if (other_second != second_) {
+        if (GetOrigin() == Origin::SEGMENT) {
+            Segment* segment = GetSegment();
+            segment->first_relinked = std::min(segment->first_relinked, segment_index_);
+        }
+        if (std::atomic_ref{GetListStamp()}.load(std::memory_order_relaxed) != 0) {
+            list_relinks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (Nursery* nursery = Nursery::Current()) {
+        nursery->RecordStore(this, other_second.get());
+    }
     second_ = other_second;
 }
 
-std::shared_ptr<Object> Quote::Apply(std::vector<std::shared_ptr<Object>>& args) {
+void Cell::DropListCursors() {
+    list_relinks.fetch_add(1, std::memory_order_relaxed);
+}
+
+Cell::Segment* Cell::GetSegment() const {
+    auto* cells = const_cast<Cell*>(this) - segment_index_;
+    return reinterpret_cast<Segment*>(reinterpret_cast<char*>(cells) - sizeof(Segment));
+}
+
+uint32_t& Cell::GetListStamp() const {
+    return GetOrigin() == Origin::SEGMENT ? GetSegment()->list_stamp
+                                          : const_cast<Cell*>(this)->list_stamp_;
+}
+
+Cell* Cell::FindInSegment(size_t steps) {
+    return steps <= GetSegmentReach() ? this + steps : nullptr;
+}
+
+size_t Cell::GetSegmentReach() const {
+    if (GetOrigin() != Origin::SEGMENT) {
+        return 0;
+    }
+    Segment* segment = GetSegment();
+    return segment_index_ < segment->first_relinked ? segment->first_relinked - segment_index_ : 0;
+}
+
+void Cell::DestroyInSegment() const {
+    Segment* segment = GetSegment();
+    this->~Cell();
+    uint32_t live_cells = segment->is_shared
+                              ? std::atomic_ref{segment->live_cells}.fetch_sub(1) - 1
+                              : --segment->live_cells;
+    if (live_cells == 0 && !segment->in_arena) {
+        ::operator delete(segment);
+    }
+}
+
+Ref<Object> Cell::MakeSegment(std::vector<Ref<Object>>& elements, Ref<Object> tail,
+                              RunArena* arena) {
+    static_assert(sizeof(Segment) % alignof(Cell) == 0);
+    auto size = static_cast<uint32_t>(elements.size());
+    size_t bytes = sizeof(Segment) + size * sizeof(Cell);
+    void* block = arena ? arena->Allocate(bytes, alignof(Cell)) : ::operator new(bytes);
+    new (block) Segment{size, size, size - 1, 0, arena != nullptr, false};
+    auto* cells = reinterpret_cast<Cell*>(static_cast<char*>(block) + sizeof(Segment));
+    Nursery* nursery = arena ? nullptr : Nursery::Current();
+    // Built back to front, so each cell is created with its successor.
+    Ref<Object> list = std::move(tail);
+    for (uint32_t i = size; i-- > 0;) {
+        auto* cell = new (cells + i) Cell(std::move(elements[i]), std::move(list));
+        cell->SetOrigin(Origin::SEGMENT);
+        cell->segment_index_ = i;
+        if (nursery) {
+            nursery->RecordStore(cell, cell->first_.get());
+            nursery->RecordStore(cell, cell->second_.get());
+        }
+        list = Ref<Object>(cell);
+    }
+    return list;
+}
+
+Ref<Object> MakeCompactList(std::vector<Ref<Object>>& elements, Ref<Object> tail) {
+    if (elements.size() < 2) {
+        return elements.empty() ? tail : MakeObject<Cell>(std::move(elements[0]), std::move(tail));
+    }
+    return Cell::MakeSegment(elements, std::move(tail), RunArena::Current());
+}
+
+// Where the last AdvanceList on this thread from `head` stopped. The cursor holds no reference, so
+// it never keeps a list alive: it is used only for a head cell with the same stamp, which a new
+// cell at the address of a freed one does not have, and only while no link a walk has followed
+// has changed, so the cells up to `position` are still alive through the head.
+struct ListCursor {
+    const Cell* head = nullptr;
+    uint32_t stamp = 0;
+    uint64_t relinks = 0;
+    size_t index = 0;
+    const Ref<Object>* position = nullptr;
+};
+
+static constexpr int kListCursorBits = 3;
+
+static thread_local std::array<ListCursor, size_t{1} << kListCursorBits> list_cursors;
+
+static ListCursor& GetListCursor(const Cell* head) {
+    // Fibonacci hashing, so that neighbouring cells get different cursors.
+    auto hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(head)) * 0x9e3779b97f4a7c15;
+    return list_cursors[hash >> (64 - kListCursorBits)];
+}
+
+ListPosition AdvanceList(const Ref<Object>& list, size_t steps) {
+    ListPosition at{&list, 0, false};
+    uint64_t relinks = list_relinks.load(std::memory_order_relaxed);
+    auto* head = TryAs<Cell>(list.get());
+    ListCursor* cursor = nullptr;
+    uint32_t stamp = 0;
+    if (head) {
+        cursor = &GetListCursor(head);
+        // Heads that are shared, or in a segment with others, may be stamped by several threads
+        // at once.
+        stamp = std::atomic_ref{head->GetListStamp()}.load(std::memory_order_relaxed);
+        if (stamp > kPassedStamp && cursor->head == head && cursor->stamp == stamp &&
+            cursor->relinks == relinks && cursor->index <= steps) {
+            at.object = cursor->position;
+            at.index = cursor->index;
+        }
+    }
+    // Brent's cycle detection: compares each position with one saved at doubling distances.
+    const Object* saved = at.object->get();
+    size_t distance = 0;
+    size_t limit = 1;
+    while (at.index < steps && Is<Cell>(*at.object)) {
+        auto& cell = AsRef<Cell>(*at.object);
+        // Relinking a cell from now on drops the cursors, which may lie past it.
+        std::atomic_ref passed{cell.GetListStamp()};
+        if (passed.load(std::memory_order_relaxed) == 0) {
+            uint32_t unpassed = 0;
+            passed.compare_exchange_strong(unpassed,
+                                           cell.GetOrigin() == RefCounted::Origin::SEGMENT
+                                               ? NewListStamp()
+                                               : kPassedStamp,
+                                           std::memory_order_relaxed);
+        }
+        size_t jump = std::min(cell.GetSegmentReach(), steps - at.index);
+        if (jump > 0) {
+            at.object = &cell.FindInSegment(jump - 1)->GetSecond();
+            at.index += jump;
+        } else {
+            at.object = &cell.GetSecond();
+            ++at.index;
+        }
+        if (at.object->get() == saved) {
+            at.is_circular = true;
+            if (steps == SIZE_MAX) {
+                return at;
+            }
+        }
+        if (++distance == limit) {
+            saved = at.object->get();
+            distance = 0;
+            limit *= 2;
+        }
+    }
+    if (cursor && at.index > 0) {
+        // The walk has passed the head, so its stamp is no longer 0.
+        stamp = std::atomic_ref{head->GetListStamp()}.load(std::memory_order_relaxed);
+        if (stamp == kPassedStamp || !IsCurrentListStamp(stamp)) {
+            uint32_t next_stamp = NewListStamp();
+            // Keeps the stamp of a thread that got there first.
+            if (std::atomic_ref{head->GetListStamp()}.compare_exchange_strong(
+                    stamp, next_stamp, std::memory_order_relaxed)) {
+                stamp = next_stamp;
+            }
+        }
+        *cursor = {head, stamp, relinks, at.index, at.object};
+    }
+    return at;
+}
+
+std::optional<size_t> GetListLength(const Ref<Object>& list) {
+    ListPosition end = AdvanceList(list, SIZE_MAX);
+    if (end.is_circular || *end.object) {
+        return std::nullopt;
+    }
+    return end.index;
+}
+
+void ShareAcrossThreads(const Ref<Object>& root) {
+    std::vector<Object*> pending{root.get()};
+    while (!pending.empty()) {
+        Object* object = pending.back();
+        pending.pop_back();
+        // Shared and pinned objects, and everything reachable from them, are done already;
+        // immediate values are not objects.
+        if (!object || IsImmediate(object) || object->IsShared()) {
+            continue;
+        }
+        object->Share();
+        if (auto* cell = TryAs<Cell>(object)) {
+            // Counts the deaths of every cell of the segment atomically from now on, since the
+            // cells left unshared may still die on this thread while the others die elsewhere.
+            // Once set, the flag is only read, so threads holding cells shared before never see
+            // it change.
+            if (cell->GetOrigin() == RefCounted::Origin::SEGMENT &&
+                !cell->GetSegment()->is_shared) {
+                cell->GetSegment()->is_shared = true;
+            }
+            if (cell->GetOrigin() == RefCounted::Origin::NURSERY) {
+                Nursery::Evict(cell);
+            }
+            cell->Untrack();
+            pending.push_back(cell->GetFirst().get());
+            pending.push_back(cell->GetSecond().get());
+        }
+    }
+}
+
+Ref<Object> Quote::Apply(std::vector<Ref<Object>>& args) {
     if (!args.empty()) {
         return args[0];
     }
 }
 
 template <typename Functor>
-std::shared_ptr<Object> Calculate<Functor>::Apply(FuncArgs& args) {
+Ref<Object> Calculate<Functor>::Apply(FuncArgs& args) {
     Functor f;
     int ans = SetDefaultValue(args);
     size_t start_index = SetStartIndex();
@@ -54,10 +410,10 @@ std::shared_ptr<Object> Calculate<Functor>::Apply(FuncArgs& args) {
         throw RuntimeError("invalid type of arguments");
     }
     for (size_t i = start_index; i < args.size(); ++i) {
-        int value = As<Number>(args[i])->GetValue();
+        int value = Number::GetValue(args[i]);
         ans = f(ans, value);
     }
-    return std::make_shared<Number>(ConstantToken{ans});
+    return Number::Make(ans);
 }
 
 template <typename Functor>
@@ -70,7 +426,7 @@ int Calculate<Functor>::SetDefaultValue(FuncArgs& args) {
     }
     if (!args.empty()) {
         if (Is<Number>(args[0])) {
-            return As<Number>(args[0])->GetValue();
+            return Number::GetValue(args[0]);
         }
     }
     throw RuntimeError("invalid type of arguments");
@@ -85,23 +441,23 @@ size_t Calculate<Functor>::SetStartIndex() {
 }
 
 template <typename Functor>
-std::shared_ptr<Object> Monotony<Functor>::Apply(FuncArgs& args) {
+Ref<Object> Monotony<Functor>::Apply(FuncArgs& args) {
     Functor f;
     if (!IsTypes<Number>(args)) {
         throw RuntimeError("invalid type of arguments");
     }
     for (size_t i = 1; i < args.size(); ++i) {
-        if (!Check(f, As<Number>(args[i - 1])->GetValue(), As<Number>(args[i])->GetValue())) {
-            return std::make_shared<Boolean>(BooleanToken{false});
+        if (!Check(f, Number::GetValue(args[i - 1]), Number::GetValue(args[i]))) {
+            return Boolean::Make(false);
         }
     }
-    return std::make_shared<Boolean>(BooleanToken{true});
+    return Boolean::Make(true);
 }
 
-std::shared_ptr<Object> Absolute::Apply(std::vector<std::shared_ptr<Object>>& args) {
+Ref<Object> Absolute::Apply(std::vector<Ref<Object>>& args) {
     if (args.size() == 1 && Is<Number>(args[0])) {
-        int value = std::abs(As<Number>(args[0])->GetValue());
-        return std::make_shared<Number>(ConstantToken{value});
+        int value = std::abs(Number::GetValue(args[0]));
+        return Number::Make(value);
     }
     throw RuntimeError("wrong type/number of arguments");
 }
@@ -111,25 +467,25 @@ bool Monotony<Functor>::Check(Functor functor, int first, int second) {
     return functor(first, second);
 }
 
-std::shared_ptr<Object> And::Apply(FuncArgs& args) {
-    std::shared_ptr<Object> current;
+Ref<Object> And::Apply(FuncArgs& args) {
+    Ref<Object> current;
     for (size_t i = 0; i < args.size(); ++i) {
         current = args[i];
         if (Is<Cell>(current)) {
             current = Unpack(current);
         }
-        if (Is<Boolean>(current) && !As<Boolean>(current)->GetValue()) {
-            return std::make_shared<Boolean>(BooleanToken{false});
+        if (Is<Boolean>(current) && !Boolean::GetValue(current)) {
+            return Boolean::Make(false);
         }
     }
     if (!args.empty()) {
         return current;
     }
-    return std::make_shared<Boolean>(BooleanToken{true});
+    return Boolean::Make(true);
 }
 
-std::shared_ptr<Object> Or::Apply(FuncArgs& args) {
-    std::shared_ptr<Object> current;
+Ref<Object> Or::Apply(FuncArgs& args) {
+    Ref<Object> current;
     for (size_t i = 0; i < args.size(); ++i) {
         current = args[i];
         if (Is<Cell>(current)) {
@@ -137,114 +493,100 @@ std::shared_ptr<Object> Or::Apply(FuncArgs& args) {
         }
         if (!Is<Boolean>(current)) {
             return current;
-        } else if (As<Boolean>(current)->GetValue()) {
-            return std::make_shared<Boolean>(BooleanToken{true});
+        } else if (Boolean::GetValue(current)) {
+            return Boolean::Make(true);
         }
     }
     if (!args.empty()) {
         return current;
     }
-    return std::make_shared<Boolean>(BooleanToken{false});
+    return Boolean::Make(false);
 }
 
-std::shared_ptr<Object> Not::Apply(FuncArgs& args) {
+Ref<Object> Not::Apply(FuncArgs& args) {
     if (args.size() == 1) {
         bool value;
         if (Is<Boolean>(args[0])) {
-            value = !As<Boolean>(args[0])->GetValue();
-            return std::make_shared<Boolean>(BooleanToken{value});
+            value = !Boolean::GetValue(args[0]);
+            return Boolean::Make(value);
         }
-        return std::make_shared<Boolean>(BooleanToken{false});
+        return Boolean::Make(false);
     }
     throw RuntimeError("wrong type/number of arguments");
 }
 
-std::shared_ptr<Object> Cons::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    return std::make_shared<Cell>(args[0], args[1]);
+Ref<Object> Cons::Apply(std::vector<Ref<Object>>& args) {
+    return MakeObject<Cell>(args[0], args[1]);
 }
 
-std::shared_ptr<Object> Car::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    std::shared_ptr<Object> list = Unpack(args[0]);
+Ref<Object> Car::Apply(std::vector<Ref<Object>>& args) {
+    Ref<Object> list = Unpack(args[0]);
     if (Is<Cell>(list)) {
         return As<Cell>(list)->GetFirst();
     }
     throw RuntimeError("Invalid arguments");
 }
 
-std::shared_ptr<Object> Cdr::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    std::shared_ptr<Object> list = Unpack(args[0]);
+Ref<Object> Cdr::Apply(std::vector<Ref<Object>>& args) {
+    Ref<Object> list = Unpack(args[0]);
     if (Is<Cell>(list)) {
         return As<Cell>(list)->GetSecond();
     }
     throw RuntimeError("Invalid arguments");
 }
 
-std::shared_ptr<Object> MakeList::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    if (args.empty()) {
-        return nullptr;
-    }
-    std::shared_ptr<Object> list = std::make_shared<Cell>(args[0], nullptr);
-    std::shared_ptr<Object> next = list;
-    for (size_t i = 1; i < args.size(); ++i) {
-        As<Cell>(next)->SetSecond(std::make_shared<Cell>(args[i], nullptr));
-        next = As<Cell>(next)->GetSecond();
-    }
-    return list;
+Ref<Object> MakeList::Apply(std::vector<Ref<Object>>& args) {
+    return MakeCompactList(args);
 }
 
-std::shared_ptr<Object> ListRef::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    std::shared_ptr<Object> list = Unpack(args[0]);
-    std::shared_ptr<Object> ans;
+Ref<Object> ListRef::Apply(std::vector<Ref<Object>>& args) {
+    Ref<Object> list = Unpack(args[0]);
     size_t index;
-    size_t cnt = 0;
     if (Is<Number>(args[1])) {
-        index = As<Number>(args[1])->GetValue();
+        index = Number::GetValue(args[1]);
     } else {
         throw RuntimeError("Invalid index type");
     }
-    while (Is<Cell>(list)) {
-        if (cnt == index) {
-            return As<Cell>(list)->GetFirst();
-        }
-        ++cnt;
-        list = As<Cell>(list)->GetSecond();
-    }
-    if (cnt != index || !list) {
+    ListPosition at = AdvanceList(list, index);
+    if (at.index != index || !Is<Cell>(*at.object)) {
         throw RuntimeError("Invalid index value");
     }
+    return AsRef<Cell>(*at.object).GetFirst();
 }
 
-std::shared_ptr<Object> ListTail::Apply(std::vector<std::shared_ptr<Object>>& args) {
-    std::shared_ptr<Object> list = Unpack(args[0]);
-    std::shared_ptr<Object> ans;
+Ref<Object> ListTail::Apply(std::vector<Ref<Object>>& args) {
+    Ref<Object> list = Unpack(args[0]);
     size_t index;
-    size_t cnt = 0;
     if (Is<Number>(args[1])) {
-        index = As<Number>(args[1])->GetValue();
+        index = Number::GetValue(args[1]);
     } else {
         throw RuntimeError("Invalid index type");
     }
-    while (Is<Cell>(list)) {
-        if (cnt == index) {
-            return As<Cell>(list);
-        }
-        ++cnt;
-        list = As<Cell>(list)->GetSecond();
+    ListPosition at = AdvanceList(list, index);
+    if (at.index != index) {
+        throw RuntimeError("Invalid index value");
     }
+    return *at.object;
+}
 
-    if (cnt == index) {
-        return list;
+Ref<Object> Length::Apply(std::vector<Ref<Object>>& args) {
+    if (args.size() != 1) {
+        throw RuntimeError("Invalid arguments");
+    }
+    std::optional<size_t> length = GetListLength(Unpack(args[0]));
+    if (!length) {
+        throw RuntimeError("Invalid list");
     }
-    throw RuntimeError("Invalid index value");
+    return Number::Make(static_cast<int>(*length));
 }
 
 template <typename T>
-std::shared_ptr<Object> Predicate<T>::Apply(FuncArgs& args) {
-    return std::make_shared<Boolean>(BooleanToken{IsTypes<T, Object>(args)});
+Ref<Object> Predicate<T>::Apply(FuncArgs& args) {
+    return Boolean::Make(IsTypes<T, Object>(args));
 }
 
 template <typename Functor>
-std::shared_ptr<Object> ListPredicate<Functor>::Apply(std::vector<std::shared_ptr<Object>>& args) {
+Ref<Object> ListPredicate<Functor>::Apply(std::vector<Ref<Object>>& args) {
     Functor f;
-    return std::make_shared<Boolean>(BooleanToken{f(args[0])});
+    return Boolean::Make(f(args[0]));
 }
@@ -1,81 +1,304 @@
 #pragma once
 
+#include <arena.h>
+#include <array>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <ref.h>
+#include <string>
+#include <string_view>
 #include <tokenizer.h>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
-class Object : public std::enable_shared_from_this<Object> {
+// Concrete type of the objects that type checks run on, stored in every object so that Is<T>
+// is a compare instead of an RTTI walk. Builtins are all OTHER.
+enum class ObjectKind : uint8_t { OTHER, SYMBOL, QUOTE, CELL };
+
+class Object : public RefCounted {
 public:
-    virtual std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) {
+    Object() = default;
+
+    ObjectKind GetKind() const {
+        return kind_;
+    }
+
+    virtual Ref<Object> Apply(std::vector<Ref<Object>> &args) {
         throw RuntimeError("Not implemented method within this object");
     };
-    virtual std::shared_ptr<Object> EvalToFunc() {
+    virtual Ref<Object> EvalToFunc() {
         throw RuntimeError("Not implemented method within this object");
     }
 
     virtual ~Object() = default;
+
+protected:
+    explicit Object(ObjectKind kind) : kind_(kind) {
+    }
+
+private:
+    ObjectKind kind_ = ObjectKind::OTHER;
 };
 
-typedef std::vector<std::shared_ptr<Object>> FuncArgs;
+typedef std::vector<Ref<Object>> FuncArgs;
 
-class Number : public Object {
+// Integers are immediate values: the word of a Ref<Object> holds the number itself, shifted left
+// by one and tagged in its low bit, so making one never allocates and copying one is never
+// counted. There are no Number objects; the class only names the type for Is<Number>.
+class Number {
 public:
-    Number(ConstantToken const_token) : value_(const_token.value){};
-    std::shared_ptr<Object> EvalToFunc() override;
-    int GetValue() const;
+    Number() = delete;
 
-private:
-    int value_;
+    static Ref<Object> Make(int value) {
+        return Ref<Object>::Adopt(
+            reinterpret_cast<Object *>(static_cast<uintptr_t>(value) << 1 | kTag));
+    }
+
+    // `number` must hold a number (see Is<Number>).
+    static int GetValue(const Object *number) {
+        return static_cast<int>(reinterpret_cast<intptr_t>(number) >> 1);
+    }
+
+    static int GetValue(const Ref<Object> &number) {
+        return GetValue(number.get());
+    }
+
+    static constexpr uintptr_t kTagMask = 1;
+    static constexpr uintptr_t kTag = 1;
 };
 
-class Boolean : public Object {
+// Booleans are immediate values like numbers: the tag 010 in the low bits, the value in bit 3.
+class Boolean {
 public:
-    Boolean(BooleanToken bool_token) : value_(bool_token.value){};
-    bool GetValue() const;
+    Boolean() = delete;
 
-private:
-    bool value_;
+    static Ref<Object> Make(bool value) {
+        return Ref<Object>::Adopt(reinterpret_cast<Object *>(uintptr_t{value} << 3 | kTag));
+    }
+
+    // `boolean` must hold a boolean (see Is<Boolean>).
+    static bool GetValue(const Object *boolean) {
+        return reinterpret_cast<uintptr_t>(boolean) >> 3;
+    }
+
+    static bool GetValue(const Ref<Object> &boolean) {
+        return GetValue(boolean.get());
+    }
+
+    static constexpr uintptr_t kTagMask = 7;
+    static constexpr uintptr_t kTag = 2;
 };
 
+static_assert(Number::kTag & kImmediateTagMask && Boolean::kTag & kImmediateTagMask);
+// Every object pointer has the tag bits clear, and a word holds any int shifted left by one.
+static_assert(alignof(Object) > kImmediateTagMask);
+static_assert(sizeof(uintptr_t) >= sizeof(int64_t));
+
+// Symbols are interned: there is exactly one Symbol per name, so two symbols are equal iff they
+// are the same object (or have the same id). Obtain them through SymbolTable::Intern.
 class Symbol : public Object {
 private:
-    friend class OperationsMap;
+    friend class SymbolTable;
+
+    Symbol(std::string name, size_t id)
+        : Object(ObjectKind::SYMBOL), name_(std::move(name)), id_(id){};
 
 public:
-    Symbol(SymbolToken symbol_token) : name_(symbol_token.name){};
     const std::string &GetName() const;
-    std::shared_ptr<Object> EvalToFunc() override;
+    size_t GetId() const;
+    Ref<Object> EvalToFunc() override;
 
 private:
     std::string name_;
+    size_t id_;
+};
+
+// Process-wide intern table mapping symbol names to small dense ids and shared Symbol instances.
+// Intern may be called from several threads; names are spread over independently locked shards
+// so that parallel readers rarely contend.
+class SymbolTable {
+public:
+    // Never destroyed: symbols are pinned, and may still be referenced while statics die.
+    static SymbolTable &Instantiate() {
+        static SymbolTable *table = new SymbolTable;
+        return *table;
+    }
+
+    Ref<Symbol> Intern(std::string_view name);
+
+    Ref<Symbol> Intern(SymbolToken symbol_token) {
+        return Intern(symbol_token.name);
+    }
+
+    size_t Size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Ref<Symbol>, NameHash, std::equal_to<>> ids;
+    };
+
+    static constexpr size_t kShardCount = 64;
+
+    std::array<Shard, kShardCount> shards_;
+    std::atomic<size_t> size_ = 0;
 };
 
 class Quote : public Object {
 public:
-    Quote(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Quote() : Object(ObjectKind::QUOTE){};
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
+// A non-empty list whose reading has been put off by the lazy reader (see ReadLazy).
+class DeferredList : public Object {
+public:
+    // Reads the list; throws SyntaxError if its source turns out to be malformed.
+    virtual Ref<Object> Read() const = 0;
+};
+
+class CycleCollector;
+struct ListPosition;
+
 class Cell : public Object {
 public:
-    Cell(std::shared_ptr<Object> first, std::shared_ptr<Object> second)
-            : first_(first), second_(second){};
+    // Cells created while a CycleCollector is current on this thread are tracked by it.
+    Cell(Ref<Object> first, Ref<Object> second);
+
+    // A deferred cell stands for the first cell of `list`, which is read on the first access to
+    // either half of the cell.
+    explicit Cell(Ref<DeferredList> list);
+
+    // Releases nested cells iteratively, so dropping a long or deep list does not recurse.
+    ~Cell() override;
 
-    std::shared_ptr<Object> GetFirst() const;
-    std::shared_ptr<Object> GetSecond() const;
-    void SetFirst(std::shared_ptr<Object> other_first);
-    void SetSecond(std::shared_ptr<Object> other_second);
+    const Ref<Object> &GetFirst() const;
+    const Ref<Object> &GetSecond() const;
+    void SetFirst(Ref<Object> other_first);
+    void SetSecond(Ref<Object> other_second);
+
+    // The cell `steps` cdrs down the list from this one, if it can be found without walking: the
+    // list between them was built by MakeCompactList and none of its cells has been relinked by
+    // SetSecond since. Returns nullptr otherwise.
+    Cell *FindInSegment(size_t steps);
+
+    // The largest number of steps for which FindInSegment succeeds.
+    size_t GetSegmentReach() const;
+
+private:
+    friend class CycleCollector;
+    friend class Nursery;
+    friend void ShareAcrossThreads(const Ref<Object> &root);
+    friend Ref<Object> MakeCompactList(std::vector<Ref<Object>> &elements, Ref<Object> tail);
+    friend ListPosition AdvanceList(const Ref<Object> &list, size_t steps);
+
+    // Header of the block holding the cells of a compact list, which follow it in list order.
+    // Aligned for the cells that follow it.
+    struct alignas(alignof(void*)) Segment {
+        uint32_t size;
+        uint32_t live_cells;
+        // The cells before it still link each to the next one.
+        uint32_t first_relinked;
+        // Identifies all the cells of the segment to the cursors of AdvanceList, which tell them
+        // apart by address; 0 until a list walk enters the segment.
+        uint32_t list_stamp;
+        bool in_arena;
+        // Some of the cells have been shared (see ShareAcrossThreads), so the cells may die on
+        // different threads, shared or not.
+        bool is_shared;
+    };
+
+    // Builds the cells of a compact list of at least two `elements`, in a block taken from
+    // `arena` if it is not null.
+    static Ref<Object> MakeSegment(std::vector<Ref<Object>> &elements, Ref<Object> tail,
+                                   RunArena *arena);
+
+    // Makes every list cursor start its next walk from the head again.
+    static void DropListCursors();
+
+    bool IsDeferred() const;
+
+    void ReadDeferred() const;
+
+    void Untrack();
+
+    Segment *GetSegment() const;
+
+    // The stamp of the cell for list cursors: its own, or its segment's.
+    uint32_t &GetListStamp() const;
+
+    void DestroyInSegment() const override;
 
 private:
-    std::shared_ptr<Object> first_;
-    std::shared_ptr<Object> second_;
+    // A deferred cell holds a marker in `first_` and its DeferredList in `second_` until it is
+    // read; the accessors are const, so reading it in place needs them mutable.
+    mutable Ref<Object> first_;
+    mutable Ref<Object> second_;
+    CycleCollector *collector_ = nullptr;
+    uint32_t collector_slot_ = 0;
+    union {
+        // Position in the segment, for cells with Origin::SEGMENT.
+        uint32_t segment_index_ = 0;
+        // Otherwise, 0 until a list walk passes the cell, then marks it as passed, or identifies it
+        // to the cursors of AdvanceList once it heads one.
+        uint32_t list_stamp_;
+    };
+};
+
+// Builds the list of `elements`, taking them out of the vector, ended by `tail` instead of the
+// empty list if it is not null. Its cells are allocated in one block in list order, so walking
+// the list reads memory sequentially and Cell::FindInSegment reaches any of them at once; the
+// block is freed with its last cell. The cells are ordinary in every other respect.
+Ref<Object> MakeCompactList(std::vector<Ref<Object>> &elements, Ref<Object> tail = nullptr);
+
+struct ListPosition {
+    // A cell, or the end of the list: nullptr, or the tail of a dotted list.
+    const Ref<Object> *object;
+    // How many cdrs down the list it is.
+    size_t index;
+    // The walk went round a cycle of cells; it only gives up on one if it was asked for SIZE_MAX
+    // steps.
+    bool is_circular;
 };
 
+// Follows up to `steps` cdrs down `list`, stopping early at its end. Intact runs of a segment are
+// jumped over (see Cell::FindInSegment), and the walk resumes from where the last one on this
+// thread from the same head cell stopped, if that was no further than `steps` and no cell that a
+// walk has passed, on any list and thread, has been relinked by SetSecond since. So indexing a
+// list at increasing positions, or measuring it again, only costs the cells in between, while
+// building and relinking other lists keeps the cursors. Each thread keeps cursors for a handful
+// of heads, picked by address: walking more lists in turn, or two whose heads collide, loses the
+// cursors.
+ListPosition AdvanceList(const Ref<Object> &list, size_t steps);
+
+// The number of cells of `list` if it is a proper list, that is nil or a chain of cells ending in
+// nil; nullopt for dotted and circular lists.
+std::optional<size_t> GetListLength(const Ref<Object> &list);
+
+// Lets several threads reference `root` and everything reachable from it at once, by switching
+// their reference counts to atomic updates (see RefCounted). Deferred lists among them are read,
+// and their cells are no longer tracked by a CycleCollector. Must be called while no other
+// thread references them yet; objects linked into a shared cell later must be shared first.
+void ShareAcrossThreads(const Ref<Object> &root);
+
 template <typename Functor>
 class Calculate : public Object {
 public:
     Calculate(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
     int SetDefaultValue(FuncArgs &args);
     size_t SetStartIndex();
 };
@@ -83,32 +306,32 @@ public:
 class Absolute : public Object {
 public:
     Absolute(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class And : public Object {
 public:
     And(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
 };
 
 class Or : public Object {
 public:
     Or(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
 };
 
 class Not : public Object {
 public:
     Not(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
 };
 
 template <typename Functor>
 class Monotony : public Object {
 public:
     Monotony(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
     bool Check(Functor functor, int first, int second);
 };
 
@@ -116,64 +339,114 @@ template <typename T>
 class Predicate : public Object {
 public:
     Predicate(){};
-    std::shared_ptr<Object> Apply(FuncArgs &args) override;
+    Ref<Object> Apply(FuncArgs &args) override;
 };
 
 template <typename Functor>
 class ListPredicate : public Object {
 public:
     ListPredicate(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class Cons : public Object {
 public:
     Cons(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class Car : public Object {
 public:
     Car(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class Cdr : public Object {
 public:
     Cdr(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class MakeList : public Object {
 public:
     MakeList(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class ListRef : public Object {
 public:
     ListRef(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
 class ListTail : public Object {
 public:
     ListTail(){};
-    std::shared_ptr<Object> Apply(std::vector<std::shared_ptr<Object>> &args) override;
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
+};
+
+class Length : public Object {
+public:
+    Length(){};
+    Ref<Object> Apply(std::vector<Ref<Object>> &args) override;
 };
 
+// Immediate values have no object to point to; read them through Number and Boolean instead.
+template <class T>
+inline constexpr bool kIsImmediateType = std::is_same_v<T, Number> || std::is_same_v<T, Boolean>;
+
 template <class T>
-std::shared_ptr<T> As(const std::shared_ptr<Object> &obj) {
+Ref<T> As(const Ref<Object> &obj) {
+    static_assert(!kIsImmediateType<T>);
     if (obj == nullptr) {
         throw RuntimeError("Invalid cast");
     }
-    return std::static_pointer_cast<T>(obj);
+    return StaticRefCast<T>(obj);
 }
 
+// Compile-time mapping from a class to its ObjectKind; OTHER for classes without their own kind.
+template <class T>
+inline constexpr ObjectKind kObjectKind = ObjectKind::OTHER;
+template <>
+inline constexpr ObjectKind kObjectKind<Symbol> = ObjectKind::SYMBOL;
+template <>
+inline constexpr ObjectKind kObjectKind<Quote> = ObjectKind::QUOTE;
+template <>
+inline constexpr ObjectKind kObjectKind<Cell> = ObjectKind::CELL;
+
 template <class T>
-bool Is(const std::shared_ptr<Object> &obj) {
-    auto ptr = std::dynamic_pointer_cast<T>(obj);
-    return ptr != nullptr;
+bool Is(const Object *obj) {
+    if constexpr (std::is_same_v<T, Object>) {
+        return obj != nullptr;
+    } else if constexpr (kIsImmediateType<T>) {
+        return (reinterpret_cast<uintptr_t>(obj) & T::kTagMask) == T::kTag;
+    } else if constexpr (kObjectKind<T> != ObjectKind::OTHER) {
+        return obj != nullptr && !IsImmediate(obj) && obj->GetKind() == kObjectKind<T>;
+    } else {
+        return obj != nullptr && !IsImmediate(obj) && dynamic_cast<const T *>(obj) != nullptr;
+    }
+}
+
+template <class T>
+bool Is(const Ref<Object> &obj) {
+    return Is<T>(obj.get());
+}
+
+// Non-owning counterpart of As, for reading an object without touching its reference count.
+template <class T>
+T &AsRef(const Ref<Object> &obj) {
+    static_assert(!kIsImmediateType<T>);
+    if (obj == nullptr) {
+        throw RuntimeError("Invalid cast");
+    }
+    return static_cast<T &>(*obj);
+}
+
+// Returns `obj` as a T, or nullptr if it is not one.
+template <class T>
+T *TryAs(Object *obj) {
+    static_assert(!kIsImmediateType<T>);
+    return Is<T>(obj) ? static_cast<T *>(obj) : nullptr;
 }
 
 template <typename T>
@@ -197,9 +470,9 @@ public:
 class NullFunc {
 public:
     NullFunc(){};
-    auto operator()(std::shared_ptr<Object> obj) {
-        if (Is<Cell>(obj) && Is<Quote>(As<Cell>(obj)->GetFirst())) {
-            obj = As<Cell>(obj)->GetSecond();
+    auto operator()(Ref<Object> obj) {
+        if (Is<Cell>(obj) && Is<Quote>(AsRef<Cell>(obj).GetFirst())) {
+            obj = AsRef<Cell>(obj).GetSecond();
         }
         return obj == nullptr;
     }
@@ -208,15 +481,15 @@ public:
 class PairFunc {
 public:
     PairFunc(){};
-    auto operator()(std::shared_ptr<Object> obj) {
-        if (Is<Cell>(obj) && Is<Quote>(As<Cell>(obj)->GetFirst())) {
-            obj = As<Cell>(obj)->GetSecond();
+    auto operator()(Ref<Object> obj) {
+        if (Is<Cell>(obj) && Is<Quote>(AsRef<Cell>(obj).GetFirst())) {
+            obj = AsRef<Cell>(obj).GetSecond();
         }
         if (Is<Cell>(obj)) {
-            auto first = As<Cell>(obj)->GetFirst();
-            auto second = As<Cell>(obj)->GetSecond();
+            auto first = AsRef<Cell>(obj).GetFirst();
+            auto second = AsRef<Cell>(obj).GetSecond();
             return !Is<Cell>(first) &&
-                   (!Is<Cell>(second) || As<Cell>(second)->GetSecond() == nullptr);
+                   (!Is<Cell>(second) || AsRef<Cell>(second).GetSecond() == nullptr);
         }
         return false;
     }
@@ -225,30 +498,11 @@ public:
 class ListFunc {
 public:
     ListFunc(){};
-    auto operator()(std::shared_ptr<Object> obj) {
-        if (Is<Cell>(obj) && Is<Quote>(As<Cell>(obj)->GetFirst())) {
-            obj = As<Cell>(obj)->GetSecond();
-        }
-        if (Is<Cell>(obj)) {
-            std::shared_ptr<Object> first = As<Cell>(obj)->GetFirst();
-            std::shared_ptr<Object> second = As<Cell>(obj)->GetSecond();
-            if (IsPairCell(first, second)) {
-                return false;
-            }
-            while (Is<Cell>(second)) {
-                first = As<Cell>(second)->GetFirst();
-                second = As<Cell>(second)->GetSecond();
-                if (IsPairCell(first, second)) {
-                    return false;
-                }
-            }
-            return true;
+    auto operator()(Ref<Object> obj) {
+        if (Is<Cell>(obj) && Is<Quote>(AsRef<Cell>(obj).GetFirst())) {
+            obj = AsRef<Cell>(obj).GetSecond();
         }
-        return obj == nullptr;
-    }
-
-    bool IsPairCell(std::shared_ptr<Object> first, std::shared_ptr<Object> second) {
-        return !Is<Cell>(first) && !Is<Cell>(second) && second != nullptr;
+        return GetListLength(obj).has_value();
     }
 };
 
@@ -264,48 +518,25 @@ using DivFunc = std::divides<int>;
 using MaxFunc = Max<int>;
 using MinFunc = Min<int>;
 
+// Builtins indexed by the id of the symbol they are bound to.
 class OperationsMap {
 public:
+    // Never destroyed, like SymbolTable.
     static OperationsMap &Instantiate() {
-        static OperationsMap map;
-        return map;
+        static OperationsMap *map = new OperationsMap;
+        return *map;
     }
 
-    auto GetOperation(std::string &name) {
-        return operations[name];
+    // Returns nullptr if no builtin is bound to the symbol.
+    Ref<Object> GetOperation(size_t symbol_id) const {
+        return symbol_id < operations_.size() ? operations_[symbol_id] : nullptr;
     }
 
-    bool CheckExistence(std::string &name) {
-        return operations.find(name) != operations.end();
-    }
+private:
+    OperationsMap();
 
-    std::map<std::string, std::shared_ptr<Object>> operations{
-            {"+", std::make_shared<Calculate<PlusFunc>>()},
-            {"-", std::make_shared<Calculate<MinusFunc>>()},
-            {"*", std::make_shared<Calculate<MultFunc>>()},
-            {"/", std::make_shared<Calculate<DivFunc>>()},
-            {"max", std::make_shared<Calculate<MaxFunc>>()},
-            {"min", std::make_shared<Calculate<MinFunc>>()},
-            {"abs", std::make_shared<Absolute>()},
-            {"or", std::make_shared<Or>()},
-            {"and", std::make_shared<And>()},
-            {"not", std::make_shared<Not>()},
-            {"boolean?", std::make_shared<Predicate<Boolean>>()},
-            {"number?", std::make_shared<Predicate<Number>>()},
-            {"null?", std::make_shared<ListPredicate<NullFunc>>()},
-            {"pair?", std::make_shared<ListPredicate<PairFunc>>()},
-            {"list?", std::make_shared<ListPredicate<ListFunc>>()},
-            {"=", std::make_shared<Monotony<EqualFunc>>()},
-            {">", std::make_shared<Monotony<GreaterFunc>>()},
-            {"<", std::make_shared<Monotony<LessFunc>>()},
-            {"<=", std::make_shared<Monotony<LessEqualFunc>>()},
-            {">=", std::make_shared<Monotony<GreaterEqualFunc>>()},
-            {"quote", std::make_shared<Quote>()},
-            {"cons", std::make_shared<Cons>()},
-            {"car", std::make_shared<Car>()},
-            {"cdr", std::make_shared<Cdr>()},
-            {"list-ref", std::make_shared<ListRef>()},
-            {"list-tail", std::make_shared<ListTail>()},
-            {"list", std::make_shared<MakeList>()},
-    };
+    void Bind(std::string_view name, Ref<Object> operation);
+
+private:
+    std::vector<Ref<Object>> operations_;
 };
@@ -1,100 +1,644 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <parser.h>
 #include <object.h>
 
-bool CheckNumToken(Token token) {
-    return std::holds_alternative<ConstantToken>(token);
+// The reader works on any token stream with the interface of TokenizerStream below, so the
+// pull-mode Tokenizer and a pre-tokenized TokenBuffer share one grammar.
+class TokenizerStream {
+public:
+    explicit TokenizerStream(Tokenizer *tokenizer) : tokenizer_(tokenizer) {
+    }
+
+    TokenKind Kind() {
+        return tokenizer_->GetKind();
+    }
+
+    bool IsEnd() {
+        return tokenizer_->IsEnd();
+    }
+
+    void Next() {
+        tokenizer_->Next();
+    }
+
+    Ref<Object> MakeNumber() {
+        return Number::Make(std::get<ConstantToken>(tokenizer_->GetToken()).value);
+    }
+
+    Ref<Object> MakeSymbol() {
+        return SymbolTable::Instantiate().Intern(std::get<SymbolToken>(tokenizer_->GetToken()));
+    }
+
+    Ref<Object> MakeBoolean() {
+        return Boolean::Make(std::get<BooleanToken>(tokenizer_->GetToken()).value);
+    }
+
+private:
+    Tokenizer *tokenizer_;
+};
+
+class TokenBufferStream {
+public:
+    explicit TokenBufferStream(const TokenBuffer &tokens) : tokens_(tokens) {
+    }
+
+    TokenKind Kind() {
+        return IsEnd() ? TokenKind::END : tokens_.kinds[position_];
+    }
+
+    bool IsEnd() {
+        return position_ == tokens_.Size();
+    }
+
+    // Mirrors Tokenizer::Next, which refuses to advance past the end of input.
+    void Next() {
+        if (IsEnd()) {
+            throw SyntaxError("error in parser occurred");
+        }
+        ++position_;
+    }
+
+    Ref<Object> MakeNumber() {
+        return Number::Make(tokens_.values[position_]);
+    }
+
+    Ref<Object> MakeSymbol() {
+        return SymbolTable::Instantiate().Intern(tokens_.GetName(position_));
+    }
+
+    Ref<Object> MakeBoolean() {
+        return Boolean::Make(tokens_.values[position_] != 0);
+    }
+
+private:
+    const TokenBuffer &tokens_;
+    size_t position_ = 0;
+};
+
+// Token stream over the canonical binary encoding described at ReadCanonical.
+class CanonicalStream {
+public:
+    explicit CanonicalStream(std::string_view input) : input_(input) {
+        Next();
+    }
+
+    TokenKind Kind() {
+        return kind_;
+    }
+
+    bool IsEnd() {
+        return kind_ == TokenKind::END;
+    }
+
+    void Next() {
+        if (position_ == input_.size()) {
+            if (IsEnd()) {
+                throw SyntaxError("error in parser occurred");
+            }
+            kind_ = TokenKind::END;
+            return;
+        }
+        char tag = input_[position_++];
+        switch (tag) {
+            case '(':
+                kind_ = TokenKind::OPEN;
+                return;
+            case ')':
+                kind_ = TokenKind::CLOSE;
+                return;
+            case '.':
+                kind_ = TokenKind::DOT;
+                return;
+            case '\'':
+                kind_ = TokenKind::QUOTE;
+                return;
+            case 't':
+            case 'f':
+                kind_ = TokenKind::BOOLEAN;
+                value_ = tag == 't';
+                return;
+            case 'i': {
+                if (input_.size() - position_ < 4) {
+                    throw SyntaxError("truncated number");
+                }
+                uint32_t bits = 0;
+                for (size_t i = 0; i < 4; ++i) {
+                    bits |= static_cast<uint32_t>(static_cast<unsigned char>(input_[position_ + i]))
+                            << (8 * i);
+                }
+                position_ += 4;
+                kind_ = TokenKind::CONSTANT;
+                value_ = static_cast<int32_t>(bits);
+                return;
+            }
+        }
+        if (tag < '1' || tag > '9') {
+            throw SyntaxError("invalid tag in canonical input");
+        }
+        size_t length = tag - '0';
+        while (position_ < input_.size() && input_[position_] >= '0' && input_[position_] <= '9') {
+            if (length > input_.size()) {
+                throw SyntaxError("invalid symbol length");
+            }
+            length = length * 10 + (input_[position_++] - '0');
+        }
+        if (position_ == input_.size() || input_[position_++] != ':' ||
+            input_.size() - position_ < length) {
+            throw SyntaxError("invalid symbol length");
+        }
+        kind_ = TokenKind::SYMBOL;
+        name_ = input_.substr(position_, length);
+        position_ += length;
+    }
+
+    Ref<Object> MakeNumber() {
+        return Number::Make(value_);
+    }
+
+    Ref<Object> MakeSymbol() {
+        return SymbolTable::Instantiate().Intern(name_);
+    }
+
+    Ref<Object> MakeBoolean() {
+        return Boolean::Make(value_ != 0);
+    }
+
+private:
+    std::string_view input_;
+    size_t position_ = 0;
+    TokenKind kind_ = TokenKind::CLOSE;
+    int value_ = 0;
+    std::string_view name_;
+};
+
+// A TokenizerStream over a buffer whose nested lists are deferred instead of read: DeferList
+// skips the list at the current open bracket and returns a deferred cell standing for it.
+class LazyTokenizerStream : public TokenizerStream {
+public:
+    LazyTokenizerStream(Tokenizer *tokenizer, const std::shared_ptr<const void> &owner)
+        : TokenizerStream(tokenizer), tokenizer_(tokenizer), owner_(owner) {
+    }
+
+    Ref<Object> DeferList();
+
+private:
+    Tokenizer *tokenizer_;
+    const std::shared_ptr<const void> &owner_;
+};
+
+// An unfinished list or quote on the reader stack.
+struct ReadFrame {
+    enum Type { LIST, QUOTE };
+
+    explicit ReadFrame(Type type) : type(type) {
+    }
+
+    Type type;
+    // Built into a compact list once the list is closed.
+    std::vector<Ref<Object>> elements;
+    Ref<Object> dotted_tail;
+    // Set after a dot; `has_dotted_tail` once the datum after it has been read.
+    bool after_dot = false;
+    bool has_dotted_tail = false;
+};
+
+// Attaches a finished datum to the innermost unfinished list, wrapping it into every quote on
+// the way. Returns true and leaves the datum in `value` once the outermost datum is finished.
+// With `quoted_data`, the quotes are made through the table, like the lists inside them.
+static bool AttachDatum(std::vector<ReadFrame> &frames, Ref<Object> &value,
+                        HashConsTable *quoted_data, size_t &quote_depth) {
+    while (!frames.empty() && frames.back().type == ReadFrame::QUOTE) {
+        value = quoted_data ? quoted_data->MakeCell(quoted_data->MakeQuote(), std::move(value))
+                            : MakeObject<Cell>(MakeObject<Quote>(), value);
+        frames.pop_back();
+        --quote_depth;
+    }
+    if (frames.empty()) {
+        return true;
+    }
+    ReadFrame &list = frames.back();
+    if (list.after_dot) {
+        list.dotted_tail = std::move(value);
+        list.has_dotted_tail = true;
+    } else {
+        list.elements.push_back(std::move(value));
+    }
+    return false;
+}
+
+// Reads one datum iteratively: unfinished lists and quotes live on a heap-allocated stack and
+// list elements are collected in a vector until the list closes, so neither nesting depth nor
+// list length consume the C++ stack.
+template <typename Stream>
+Ref<Object> ReadOne(Stream &stream, HashConsTable *quoted_data = nullptr) {
+    std::vector<ReadFrame> frames;
+    size_t quote_depth = 0;
+    while (true) {
+        TokenKind kind = stream.Kind();
+        ReadFrame *list = !frames.empty() && frames.back().type == ReadFrame::LIST
+                                  ? &frames.back()
+                                  : nullptr;
+        if (list && list->has_dotted_tail && kind != TokenKind::CLOSE) {
+            throw SyntaxError("error in parser occurred");
+        }
+        Ref<Object> value;
+        switch (kind) {
+            case TokenKind::CONSTANT:
+                value = stream.MakeNumber();
+                break;
+            case TokenKind::SYMBOL:
+                value = stream.MakeSymbol();
+                break;
+            case TokenKind::BOOLEAN:
+                value = stream.MakeBoolean();
+                break;
+            case TokenKind::OPEN:
+                if constexpr (requires { stream.DeferList(); }) {
+                    if (!frames.empty()) {
+                        value = stream.DeferList();
+                        break;
+                    }
+                }
+                stream.Next();
+                if (stream.Kind() == TokenKind::DOT) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                frames.emplace_back(ReadFrame::LIST);
+                continue;
+            case TokenKind::QUOTE:
+                stream.Next();
+                frames.emplace_back(ReadFrame::QUOTE);
+                ++quote_depth;
+                continue;
+            case TokenKind::DOT:
+                if (!list || list->elements.empty() || list->after_dot) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                list->after_dot = true;
+                stream.Next();
+                continue;
+            case TokenKind::CLOSE:
+                if (!list || list->after_dot != list->has_dotted_tail) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                // Quoted data is hash-consed as it is built, from the innermost list out.
+                value = quoted_data && quote_depth > 0
+                            ? quoted_data->MakeList(list->elements, std::move(list->dotted_tail))
+                            : MakeCompactList(list->elements, std::move(list->dotted_tail));
+                frames.pop_back();
+                break;
+            case TokenKind::END:
+                throw SyntaxError("error in parser occurred");
+        }
+        stream.Next();
+        if (AttachDatum(frames, value, quoted_data, quote_depth)) {
+            return value;
+        }
+    }
 }
 
-bool CheckSymbolToken(Token token) {
-    return std::holds_alternative<SymbolToken>(token);
+template <typename Stream>
+Ref<Object> ReadAll(Stream &stream, HashConsTable *quoted_data = nullptr) {
+    Ref<Object> ast = ReadOne(stream, quoted_data);
+    if (!stream.IsEnd() || Is<Quote>(ast)) {
+        throw SyntaxError("error in parser occurred");
+    }
+    return ast;
 }
 
-bool CheckDotToken(Token token) {
-    return std::holds_alternative<DotToken>(token);
+Ref<Object> Read(Tokenizer *tokenizer, HashConsTable *quoted_data) {
+    TokenizerStream stream{tokenizer};
+    return ReadAll(stream, quoted_data);
 }
 
-bool CheckOpenBracketToken(Token token) {
-    return token == Token{BracketToken::OPEN};
+Ref<Object> ReadNext(Tokenizer *tokenizer, HashConsTable *quoted_data) {
+    TokenizerStream stream{tokenizer};
+    return ReadOne(stream, quoted_data);
 }
 
-bool CheckCloseBracketToken(Token token) {
-    return token == Token{BracketToken::CLOSE};
+Ref<Object> Read(const TokenBuffer &tokens) {
+    TokenBufferStream stream{tokens};
+    return ReadAll(stream);
 }
 
-bool CheckQuoteToken(Token token) {
-    return std::holds_alternative<QuoteToken>(token);
+// State of an unfinished list or quote for ReadEvents.
+enum class EventFrame : uint8_t { QUOTE, EMPTY_LIST, LIST, AFTER_DOT, DOTTED_TAIL };
+
+void ReadEvents(Tokenizer *tokenizer, DatumHandler *handler) {
+    std::vector<EventFrame> frames;
+    while (true) {
+        TokenKind kind = tokenizer->GetKind();
+        EventFrame *frame = frames.empty() ? nullptr : &frames.back();
+        if (frame && *frame == EventFrame::DOTTED_TAIL && kind != TokenKind::CLOSE) {
+            throw SyntaxError("error in parser occurred");
+        }
+        switch (kind) {
+            case TokenKind::CONSTANT:
+                handler->OnNumber(std::get<ConstantToken>(tokenizer->GetToken()).value);
+                break;
+            case TokenKind::SYMBOL:
+                handler->OnSymbol(std::get<SymbolToken>(tokenizer->GetToken()).name);
+                break;
+            case TokenKind::BOOLEAN:
+                handler->OnBoolean(std::get<BooleanToken>(tokenizer->GetToken()).value);
+                break;
+            case TokenKind::OPEN:
+                tokenizer->Next();
+                if (tokenizer->GetKind() == TokenKind::DOT) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                frames.push_back(EventFrame::EMPTY_LIST);
+                handler->OnBeginList();
+                continue;
+            case TokenKind::QUOTE:
+                tokenizer->Next();
+                frames.push_back(EventFrame::QUOTE);
+                handler->OnQuote();
+                continue;
+            case TokenKind::DOT:
+                if (!frame || *frame != EventFrame::LIST) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                *frame = EventFrame::AFTER_DOT;
+                handler->OnDot();
+                tokenizer->Next();
+                continue;
+            case TokenKind::CLOSE:
+                if (!frame || *frame == EventFrame::QUOTE || *frame == EventFrame::AFTER_DOT) {
+                    throw SyntaxError("error in parser occurred");
+                }
+                frames.pop_back();
+                handler->OnEndList();
+                break;
+            case TokenKind::END:
+                throw SyntaxError("error in parser occurred");
+        }
+        tokenizer->Next();
+        // A finished datum completes every quote before it and becomes an element of the
+        // innermost list, or its tail.
+        while (!frames.empty() && frames.back() == EventFrame::QUOTE) {
+            frames.pop_back();
+        }
+        if (frames.empty()) {
+            return;
+        }
+        frames.back() =
+                frames.back() == EventFrame::AFTER_DOT ? EventFrame::DOTTED_TAIL : EventFrame::LIST;
+    }
 }
 
-bool CheckBooleanToken(Token token) {
-    return std::holds_alternative<BooleanToken>(token);
+Ref<Object> ReadCanonical(std::string_view input) {
+    CanonicalStream stream{input};
+    return ReadAll(stream);
 }
 
-std::shared_ptr <Object> ReadOne(Tokenizer *tokenizer);
+// Source text of a deferred list and the owner keeping it alive.
+class LazyList : public DeferredList {
+public:
+    LazyList(std::string_view text, std::shared_ptr<const void> owner)
+        : text_(text), owner_(std::move(owner)) {
+    }
 
-std::shared_ptr <Object> ReadList(Tokenizer *tokenizer) {
+    Ref<Object> Read() const override {
+        Tokenizer tokenizer{text_};
+        LazyTokenizerStream stream{&tokenizer, owner_};
+        return ReadAll(stream);
+    }
 
-    std::shared_ptr <Object> first;
-    std::shared_ptr <Object> second;
-    Token current_token = tokenizer->GetToken();
+private:
+    std::string_view text_;
+    std::shared_ptr<const void> owner_;
+};
 
-    if (CheckOpenBracketToken(current_token)) {
-        first = ReadOne(tokenizer);
-        second = ReadList(tokenizer);
-        return std::make_shared<Cell>(first, second);
+Ref<Object> LazyTokenizerStream::DeferList() {
+    std::string_view list = tokenizer_->SkipList();
+    // The empty list is nullptr rather than a cell, so it cannot be deferred.
+    if (list.find_first_not_of(" \n", 1) == list.size() - 1) {
+        return nullptr;
     }
-    if (CheckDotToken(current_token)) {
-        tokenizer->Next();
-        first = ReadOne(tokenizer);
-        return first;
-    }
-
-    if (!CheckCloseBracketToken(current_token)) {
-        first = ReadOne(tokenizer);
-        second = ReadList(tokenizer);
-        return std::make_shared<Cell>(first, second);
-    }
-    return nullptr;
-}
-
-std::shared_ptr <Object> ReadOne(Tokenizer *tokenizer) {
-    if (!tokenizer->IsEnd()) {
-        Token current_token = tokenizer->GetToken();
-        std::shared_ptr <Object> ptr;
-        if (CheckNumToken(current_token)) {
-            Number num(std::get<ConstantToken>(current_token));
-            ptr = std::make_shared<Number>(num);
-        } else if (CheckSymbolToken(current_token)) {
-            Symbol symbol(std::get<SymbolToken>(current_token));
-            ptr = std::make_shared<Symbol>(symbol);
-        } else if (CheckOpenBracketToken(current_token)) {
-            tokenizer->Next();
-            if (CheckDotToken(tokenizer->GetToken())) {
-                throw SyntaxError("error in parser occurred");
+    return MakeObject<Cell>(MakeObject<LazyList>(list, owner_));
+}
+
+std::vector<Ref<Object>> ReadLazy(std::string_view source, std::shared_ptr<const void> owner) {
+    std::vector<Ref<Object>> datums;
+    Tokenizer tokenizer{source};
+    LazyTokenizerStream stream{&tokenizer, owner};
+    while (!tokenizer.IsEnd()) {
+        datums.push_back(ReadOne(stream));
+    }
+    return datums;
+}
+
+// Splits `input` into at most `chunk_count` chunks of roughly equal size, cutting only between
+// top-level datums: at a space at bracket depth 0 that does not follow a quote. Returns the chunk
+// boundaries, starting with 0 and ending with input.size().
+static std::vector<size_t> SplitAtTopLevel(std::string_view input, size_t chunk_count) {
+    std::vector<size_t> bounds{0};
+    size_t chunk_size = input.size() / chunk_count + 1;
+    size_t next_cut = chunk_size;
+    size_t depth = 0;
+    bool after_quote = false;
+    for (size_t i = 0; i < input.size(); ++i) {
+        char symbol = input[i];
+        if (symbol == '(') {
+            ++depth;
+        } else if (symbol == ')') {
+            // Unbalanced input is left for the reader of the chunk to report.
+            depth -= depth > 0;
+        } else if (symbol == ' ' || symbol == '\n') {
+            if (i >= next_cut && depth == 0 && !after_quote) {
+                bounds.push_back(i);
+                next_cut = i + chunk_size;
             }
-            ptr = ReadList(tokenizer);
-        } else if (CheckDotToken(current_token)) {
-            throw SyntaxError("error in parser occurred");
-        } else if (CheckQuoteToken(current_token)) {
-            tokenizer->Next();
-            return std::make_shared<Cell>(std::make_shared<Quote>(), ReadOne(tokenizer));
-        } else if (CheckBooleanToken(current_token)) {
-            BooleanToken boolean(std::get<BooleanToken>(current_token));
-            ptr = std::make_shared<Boolean>(boolean);
+            continue;
         }
-        tokenizer->Next();
-        return ptr;
-    } else {
-        throw SyntaxError("error in parser occurred");
+        after_quote = symbol == '\'';
     }
+    bounds.push_back(input.size());
+    return bounds;
 }
 
-std::shared_ptr <Object> Read(Tokenizer *tokenizer) {
-    std::shared_ptr <Object> ast = ReadOne(tokenizer);
-    if (!tokenizer->IsEnd() || Is<Quote>(ast)) {
+ParsedDatums ReadParallel(std::string_view input, size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    // Several chunks per thread even out chunks that turn out to be slower to parse.
+    std::vector<size_t> bounds = SplitAtTopLevel(input, threads * 4);
+    size_t chunk_count = bounds.size() - 1;
+
+    std::vector<std::unique_ptr<RunArena>> regions(chunk_count);
+    std::vector<std::vector<Ref<Object>>> chunk_datums(chunk_count);
+    std::vector<std::exception_ptr> errors(chunk_count);
+    std::atomic<size_t> next_chunk = 0;
+    auto worker = [&] {
+        for (size_t chunk; (chunk = next_chunk.fetch_add(1)) < chunk_count;) {
+            regions[chunk] = std::make_unique<RunArena>(nullptr);
+            try {
+                Tokenizer tokenizer{input.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk])};
+                while (!tokenizer.IsEnd()) {
+                    chunk_datums[chunk].push_back(ReadNext(&tokenizer));
+                }
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+            regions[chunk]->Detach();
+        }
+    };
+    {
+        std::vector<std::jthread> pool;
+        for (size_t i = 1; i < std::min(threads, chunk_count); ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+    }
+
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    ParsedDatums result;
+    result.regions = std::move(regions);
+    size_t total = 0;
+    for (const auto &datums : chunk_datums) {
+        total += datums.size();
+    }
+    result.datums.reserve(total);
+    for (auto &datums : chunk_datums) {
+        std::move(datums.begin(), datums.end(), std::back_inserter(result.datums));
+    }
+    return result;
+}
+
+IncrementalReader::IncrementalReader() = default;
+
+IncrementalReader::~IncrementalReader() = default;
+
+// Bytes that always end a token; the bytes up to one of them can be tokenized on their own.
+static bool IsTokenBoundary(char symbol) {
+    return symbol == ' ' || symbol == '\n' || symbol == '(' || symbol == ')' || symbol == '\'';
+}
+
+void IncrementalReader::Feed(std::string_view chunk) {
+    try {
+        auto boundary = std::find_if(chunk.begin(), chunk.end(), IsTokenBoundary);
+        atom_.append(chunk.begin(), boundary);
+        if (boundary == chunk.end()) {
+            return;
+        }
+        if (!atom_.empty()) {
+            ReadTokens(atom_);
+            atom_.clear();
+        }
+        size_t begin = boundary - chunk.begin();
+        size_t end = chunk.rend() - std::find_if(chunk.rbegin(), chunk.rend(), IsTokenBoundary);
+        ReadTokens(chunk.substr(begin, end - begin));
+        atom_.assign(chunk.substr(end));
+    } catch (const SyntaxError&) {
+        Reset();
+        throw;
+    }
+}
+
+void IncrementalReader::Finish() {
+    try {
+        if (!atom_.empty()) {
+            ReadTokens(atom_);
+            atom_.clear();
+        }
+    } catch (const SyntaxError&) {
+        Reset();
+        throw;
+    }
+    if (!frames_.empty()) {
+        Reset();
+        throw SyntaxError("unexpected end of input");
+    }
+}
+
+bool IncrementalReader::HasDatum() const {
+    return !datums_.empty();
+}
+
+Ref<Object> IncrementalReader::TakeDatum() {
+    auto datum = datums_.front();
+    datums_.pop_front();
+    return datum;
+}
+
+void IncrementalReader::ReadTokens(std::string_view text) {
+    Tokenizer tokenizer{text};
+    TokenizerStream stream{&tokenizer};
+    while (!stream.IsEnd()) {
+        TokenKind kind = stream.Kind();
+        switch (kind) {
+            case TokenKind::CONSTANT:
+                ReadToken(kind, stream.MakeNumber());
+                break;
+            case TokenKind::SYMBOL:
+                ReadToken(kind, stream.MakeSymbol());
+                break;
+            case TokenKind::BOOLEAN:
+                ReadToken(kind, stream.MakeBoolean());
+                break;
+            default:
+                ReadToken(kind);
+        }
+        stream.Next();
+    }
+}
+
+// The grammar of ReadOne, driven one token at a time.
+void IncrementalReader::ReadToken(TokenKind kind, Ref<Object> value) {
+    ReadFrame *list =
+        !frames_.empty() && frames_.back().type == ReadFrame::LIST ? &frames_.back() : nullptr;
+    if (list && list->has_dotted_tail && kind != TokenKind::CLOSE) {
         throw SyntaxError("error in parser occurred");
     }
-    return ast;
+    switch (kind) {
+        case TokenKind::CONSTANT:
+        case TokenKind::SYMBOL:
+        case TokenKind::BOOLEAN:
+            break;
+        case TokenKind::OPEN:
+            frames_.emplace_back(ReadFrame::LIST);
+            return;
+        case TokenKind::QUOTE:
+            frames_.emplace_back(ReadFrame::QUOTE);
+            ++quote_depth_;
+            return;
+        case TokenKind::DOT:
+            if (!list || list->elements.empty() || list->after_dot) {
+                throw SyntaxError("error in parser occurred");
+            }
+            list->after_dot = true;
+            return;
+        case TokenKind::CLOSE:
+            if (frames_.empty()) {
+                throw SyntaxError("unexpected close bracket");
+            }
+            if (!list || list->after_dot != list->has_dotted_tail) {
+                throw SyntaxError("error in parser occurred");
+            }
+            value = MakeCompactList(list->elements, std::move(list->dotted_tail));
+            frames_.pop_back();
+            break;
+        case TokenKind::END:
+            throw SyntaxError("error in parser occurred");
+    }
+    if (AttachDatum(frames_, value, nullptr, quote_depth_)) {
+        datums_.push_back(std::move(value));
+    }
+}
+
+void IncrementalReader::Reset() {
+    atom_.clear();
+    frames_.clear();
+    quote_depth_ = 0;
 }
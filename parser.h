@@ -1,5 +1,119 @@
 #pragma once
 
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <hash_cons.h>
 #include <object.h>
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer);
+// With `quoted_data`, quoted datums are hash-consed into it, so equal quoted subtrees share
+// one object graph.
+Ref<Object> Read(Tokenizer* tokenizer, HashConsTable* quoted_data = nullptr);
+
+// Reads the next datum and leaves the tokenizer at the token after it, which may be the start
+// of another datum.
+Ref<Object> ReadNext(Tokenizer* tokenizer, HashConsTable* quoted_data = nullptr);
+
+// Reads one datum from a pre-tokenized buffer; `tokens` must hold exactly one datum.
+Ref<Object> Read(const TokenBuffer& tokens);
+
+// Reads one datum from its canonical binary encoding, the length-prefixed counterpart of the
+// text syntax in the style of canonical S-expressions. There are no spaces; each part of a
+// datum is one of:
+//   ( ) . '         list brackets, dotted tail and quote, as in text;
+//   <len>:<bytes>   a symbol: its name's length in decimal without leading zeros, then the name;
+//   i<4 bytes>      a number, as a 32-bit little-endian two's complement integer;
+//   t f             the booleans.
+// Throws SyntaxError if `input` is not exactly one well-formed datum.
+Ref<Object> ReadCanonical(std::string_view input);
+
+// Receives the parts of a datum from ReadEvents, in source order. A quote applies to the datum
+// reported after it; a dot announces the tail of the enclosing list. Every method does nothing
+// by default.
+class DatumHandler {
+public:
+    virtual void OnBeginList() {
+    }
+    virtual void OnEndList() {
+    }
+    virtual void OnDot() {
+    }
+    virtual void OnQuote() {
+    }
+    virtual void OnNumber(int /*value*/) {
+    }
+    // `name` is only valid during the call.
+    virtual void OnSymbol(std::string_view /*name*/) {
+    }
+    virtual void OnBoolean(bool /*value*/) {
+    }
+
+    virtual ~DatumHandler() = default;
+};
+
+// Event-driven counterpart of ReadNext: reports the next datum to `handler` without building any
+// objects, and leaves the tokenizer at the token after it. Memory use grows with nesting depth
+// only, one byte per level. Throws SyntaxError on malformed input, possibly after some events of
+// the datum have been reported.
+void ReadEvents(Tokenizer* tokenizer, DatumHandler* handler);
+
+// Reads every top-level datum of `source`, but defers each list nested in one: it is only
+// bracket-matched, and read on the first access to its cell, again deferring the lists inside it.
+// `owner` keeps `source` alive for as long as any of the datums does. A malformed deferred list
+// throws SyntaxError when it is first accessed rather than here. Deferred lists are allocated
+// from the RunArena current when they are read.
+std::vector<Ref<Object>> ReadLazy(std::string_view source, std::shared_ptr<const void> owner);
+
+// Datums read by ReadParallel, in source order. They are allocated from `regions` (one arena per
+// chunk), so they must not be kept beyond the ParsedDatums they came from.
+struct ParsedDatums {
+    std::vector<std::unique_ptr<RunArena>> regions;
+    std::vector<Ref<Object>> datums;
+};
+
+// Reads every top-level datum of `input` on `threads` threads. A bracket-depth pre-scan splits the
+// input between top-level datums into chunks which are then parsed concurrently. Throws the
+// error of the first chunk, in source order, that fails to parse.
+ParsedDatums ReadParallel(std::string_view input, size_t threads);
+
+struct ReadFrame;
+
+// Push-mode reader: the caller feeds arbitrary chunks of input as they arrive and takes every
+// complete top-level datum as soon as its last byte has been fed. Each chunk is tokenized once,
+// up to its last delimiter, into a reader stack that keeps the unfinished lists and quotes
+// between feeds; only the atom cut by the end of a chunk is kept as text until the next one. A
+// top-level atom is complete only once a delimiter follows it, or on Finish(). Syntax errors are
+// thrown from Feed/Finish and discard the unfinished input.
+class IncrementalReader {
+public:
+    IncrementalReader();
+
+    ~IncrementalReader();
+
+    void Feed(std::string_view chunk);
+
+    // Marks the end of input; throws SyntaxError if a datum is still incomplete.
+    void Finish();
+
+    bool HasDatum() const;
+
+    Ref<Object> TakeDatum();
+
+private:
+    // Reads the tokens of `text`, which must end at a token boundary.
+    void ReadTokens(std::string_view text);
+
+    // Adds a token to the datum being read; `value` is the object of an atom.
+    void ReadToken(TokenKind kind, Ref<Object> value = nullptr);
+
+    void Reset();
+
+private:
+    // The atom at the end of the input fed so far, while no delimiter has followed it.
+    std::string atom_;
+    std::vector<ReadFrame> frames_;
+    size_t quote_depth_ = 0;
+    std::deque<Ref<Object>> datums_;
+};
@@ -0,0 +1,44 @@
+#include <ref.h>
+
+#include <nursery.h>
+#include <slab.h>
+
+#include <exception>
+
+void RefCounted::SetOrigin(Origin origin, size_t size) {
+    origin_ = origin;
+    slab_units_ = static_cast<uint8_t>((size + SlabPool::kGranularity - 1) / SlabPool::kGranularity);
+}
+
+void RefCounted::Destroy() const {
+    switch (origin_) {
+        case Origin::HEAP:
+            delete this;
+            break;
+        case Origin::SLAB: {
+            size_t size = slab_units_ * SlabPool::kGranularity;
+            void* block = dynamic_cast<void*>(const_cast<RefCounted*>(this));
+            this->~RefCounted();
+            SlabPool::Deallocate(block, size);
+            break;
+        }
+        case Origin::ARENA:
+            // The arena takes the memory back all at once.
+            this->~RefCounted();
+            break;
+        case Origin::SEGMENT:
+            DestroyInSegment();
+            break;
+        case Origin::NURSERY: {
+            void* slot = dynamic_cast<void*>(const_cast<RefCounted*>(this));
+            this->~RefCounted();
+            Nursery::Deallocate(slot);
+            break;
+        }
+    }
+}
+
+void RefCounted::DestroyInSegment() const {
+    // Only classes that allocate segments set Origin::SEGMENT, and they override this.
+    std::terminate();
+}
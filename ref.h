@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Base of the objects that Ref points to: the reference count lives in the object itself. An
+// interpreter heap is used by one thread at a time, so the count is a plain integer and copying a
+// Ref costs no lock-prefixed instruction. Objects that several threads must reference at once go
+// through ShareAcrossThreads first, which switches their counts to atomic updates; process-wide
+// constants (interned symbols, builtins) are pinned instead and not counted at
+// all. Handing a whole heap over to another thread (through a queue or a join) needs neither.
+class RefCounted {
+public:
+    // How the memory of an object is returned once its count drops to zero. A SEGMENT object
+    // shares its block with others and frees it through DestroyInSegment; a NURSERY one lives in
+    // a slot of a Nursery chunk.
+    enum class Origin : uint8_t { HEAP, SLAB, ARENA, SEGMENT, NURSERY };
+
+    RefCounted() = default;
+
+    // Copies of an object start out unreferenced, like any new object.
+    RefCounted(const RefCounted &) {
+    }
+
+    RefCounted &operator=(const RefCounted &) {
+        return *this;
+    }
+
+    virtual ~RefCounted() = default;
+
+    void Retain() const {
+        if (mode_ == Mode::LOCAL) [[likely]] {
+            ++refs_;
+        } else if (mode_ == Mode::SHARED) {
+            std::atomic_ref{refs_}.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Release() const {
+        if (mode_ == Mode::LOCAL) [[likely]] {
+            if (--refs_ == 0) {
+                Destroy();
+            }
+        } else if (mode_ == Mode::SHARED) {
+            if (std::atomic_ref{refs_}.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Destroy();
+            }
+        }
+    }
+
+    // Meaningless for pinned objects.
+    uint32_t GetRefCount() const {
+        if (mode_ == Mode::SHARED) {
+            return std::atomic_ref{refs_}.load(std::memory_order_acquire);
+        }
+        return refs_;
+    }
+
+    bool IsShared() const {
+        return mode_ != Mode::LOCAL;
+    }
+
+    // Counts references atomically from now on. Must be called while only one thread holds the
+    // object.
+    void Share() const {
+        if (mode_ == Mode::LOCAL) {
+            mode_ = Mode::SHARED;
+        }
+    }
+
+    // Stops counting references: the object lives until the end of the process and may be
+    // referenced from any thread. For objects allocated with new.
+    void Pin() const {
+        mode_ = Mode::PINNED;
+    }
+
+    // Records how the object was allocated; `size` is its size for Origin::SLAB.
+    void SetOrigin(Origin origin, size_t size = 0);
+
+    Origin GetOrigin() const {
+        return origin_;
+    }
+
+protected:
+    // Runs the destructor of an Origin::SEGMENT object and gives its share of the block back.
+    virtual void DestroyInSegment() const;
+
+private:
+    enum class Mode : uint8_t { LOCAL, SHARED, PINNED };
+
+    // Runs the destructor and gives the memory back according to the origin.
+    void Destroy() const;
+
+private:
+    mutable uint32_t refs_ = 0;
+    mutable Mode mode_ = Mode::LOCAL;
+    Origin origin_ = Origin::HEAP;
+    // Size of a slab block, in SlabPool::kGranularity units.
+    uint8_t slab_units_ = 0;
+};
+
+// A Ref word with any of these bits set holds an immediate value (see Number and Boolean) instead
+// of a pointer. Objects are at least 8-byte aligned, so pointers have them clear.
+inline constexpr uintptr_t kImmediateTagMask = 7;
+
+inline bool IsImmediate(const void *ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) & kImmediateTagMask;
+}
+
+// Owning handle to a RefCounted object, with the interface of shared_ptr that the interpreter
+// uses. Since the count is intrusive, a Ref can be made from a raw pointer at any time. A
+// Ref<Object> may hold an immediate value instead, which is copied without any counting.
+template <class T>
+class Ref {
+public:
+    Ref() = default;
+
+    Ref(std::nullptr_t) {
+    }
+
+    explicit Ref(T *ptr) : ptr_(ptr) {
+        if (IsCounted(ptr_)) {
+            ptr_->Retain();
+        }
+    }
+
+    Ref(const Ref &other) : Ref(other.ptr_) {
+    }
+
+    Ref(Ref &&other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {
+    }
+
+    template <class U>
+        requires std::is_convertible_v<U *, T *>
+    Ref(const Ref<U> &other) : Ref(other.get()) {
+    }
+
+    template <class U>
+        requires std::is_convertible_v<U *, T *>
+    Ref(Ref<U> &&other) noexcept : ptr_(other.release()) {
+    }
+
+    Ref &operator=(Ref other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        return *this;
+    }
+
+    ~Ref() {
+        if (IsCounted(ptr_)) {
+            ptr_->Release();
+        }
+    }
+
+    T *get() const {
+        return ptr_;
+    }
+
+    T *operator->() const {
+        return ptr_;
+    }
+
+    T &operator*() const {
+        return *ptr_;
+    }
+
+    explicit operator bool() const {
+        return ptr_ != nullptr;
+    }
+
+    void reset() {
+        Ref().swap(*this);
+    }
+
+    void swap(Ref &other) noexcept {
+        std::swap(ptr_, other.ptr_);
+    }
+
+    // 0 for null and immediate values.
+    long use_count() const {
+        return IsCounted(ptr_) ? ptr_->GetRefCount() : 0;
+    }
+
+    // Gives up ownership without releasing the reference.
+    T *release() {
+        return std::exchange(ptr_, nullptr);
+    }
+
+    // Takes over a reference that is already counted, as returned by release().
+    static Ref Adopt(T *ptr) {
+        Ref ref;
+        ref.ptr_ = ptr;
+        return ref;
+    }
+
+    template <class U>
+    bool operator==(const Ref<U> &other) const {
+        return ptr_ == other.get();
+    }
+
+    bool operator==(std::nullptr_t) const {
+        return ptr_ == nullptr;
+    }
+
+private:
+    static bool IsCounted(const T *ptr) {
+        return ptr && !IsImmediate(ptr);
+    }
+
+private:
+    T *ptr_ = nullptr;
+};
+
+template <class T, class U>
+Ref<T> StaticRefCast(Ref<U> ref) {
+    return Ref<T>::Adopt(static_cast<T *>(ref.release()));
+}
+
+// Allocates a pinned object with new, for constants that live as long as the process.
+template <class T, class... Args>
+Ref<T> MakePinned(Args &&...args) {
+    T *object = new T(std::forward<Args>(args)...);
+    object->Pin();
+    return Ref<T>(object);
+}
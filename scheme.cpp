@@ -1,48 +1,228 @@
 #include "scheme.h"
 
-std::string Interpreter::Run(const std::string& str) {
-    std::stringstream ss{str};
-    Tokenizer tokenizer{&ss};
-    auto ast = Read(&tokenizer);
+#include <fasl.h>
+#include <mapped_file.h>
+#include <spsc_queue.h>
+
+#include <exception>
+#include <optional>
+#include <thread>
+
+std::string Interpreter::Run(std::string_view input) {
+    // Declared first so that every object of this run is gone before the arena is released.
+    std::optional<RunArena> arena;
+    if (use_arena_) {
+        arena.emplace(&arena_allocation_count_);
+    }
+    Tokenizer tokenizer{input};
+    return Evaluate(Read(&tokenizer));
+}
+
+std::string Interpreter::Evaluate(Ref<Object> ast) {
     auto final_ast = Unpack<Object>(ast);
     return PerformOutput(final_ast);
 }
 
-void Interpreter::Serialize(std::shared_ptr<Object> ast, std::string& ans) {
+// Consecutive forms read by the program reader thread, followed by the end of the program or
+// by a read error. Forms are handed over in batches so that the threads do not have to wake each
+// other up for every form.
+struct ProgramBatch {
+    std::vector<Ref<Object>> forms;
+    std::exception_ptr error;
+    bool is_end = false;
+};
+
+static constexpr size_t kProgramQueueCapacity = 16;
+static constexpr size_t kProgramBatchSize = 32;
+
+static void ReadProgram(std::string_view program, SpscQueue<ProgramBatch>* batches) {
+    ProgramBatch batch;
+    try {
+        Tokenizer tokenizer{program};
+        while (!tokenizer.IsEnd()) {
+            batch.forms.push_back(ReadNext(&tokenizer));
+            if (batch.forms.size() == kProgramBatchSize) {
+                if (!batches->Push(std::move(batch))) {
+                    return;
+                }
+                batch = ProgramBatch{};
+            }
+        }
+        batch.is_end = true;
+    } catch (...) {
+        batch.error = std::current_exception();
+    }
+    batches->Push(std::move(batch));
+}
+
+std::vector<std::string> Interpreter::RunProgram(std::string_view program) {
+    SpscQueue<ProgramBatch> batches{kProgramQueueCapacity};
+    std::jthread reader{ReadProgram, program, &batches};
+    std::vector<std::string> results;
+    try {
+        while (true) {
+            ProgramBatch batch = batches.Pop();
+            for (auto& form : batch.forms) {
+                // Forms are read on the reader thread, so only evaluation temporaries use the
+                // arena.
+                std::optional<RunArena> arena;
+                if (use_arena_) {
+                    arena.emplace(&arena_allocation_count_);
+                }
+                results.push_back(Evaluate(std::move(form)));
+            }
+            if (batch.error) {
+                std::rethrow_exception(batch.error);
+            }
+            if (batch.is_end) {
+                return results;
+            }
+        }
+    } catch (...) {
+        // Unblocks the reader before it is joined.
+        batches.Close();
+        throw;
+    }
+}
+
+std::string Interpreter::RunFile(const std::string& path) {
+    MappedFile file{path};
+    return Run(file.View());
+}
+
+std::vector<std::string> Interpreter::RunCachedFile(const std::string& path,
+                                                    const std::string& cache_dir) {
+    MappedFile file{path};
+    std::vector<std::string> results;
+    for (auto& form : ReadCached(file.View(), cache_dir)) {
+        std::optional<RunArena> arena;
+        if (use_arena_) {
+            arena.emplace(&arena_allocation_count_);
+        }
+        results.push_back(Evaluate(std::move(form)));
+    }
+    return results;
+}
+
+std::vector<std::string> Interpreter::RunLazyFile(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    std::vector<std::string> results;
+    for (auto& form : ReadLazy(file->View(), file)) {
+        std::optional<RunArena> arena;
+        if (use_arena_) {
+            arena.emplace(&arena_allocation_count_);
+        }
+        results.push_back(Evaluate(std::move(form)));
+    }
+    return results;
+}
+
+void Interpreter::Serialize(Ref<Object> ast, std::string& ans) {
+    // Walks the cdr chain in a loop, so long lists do not recurse per element.
+    while (Is<Cell>(ast)) {
+        Ref<Object> first = AsRef<Cell>(ast).GetFirst();
+        Ref<Object> second = AsRef<Cell>(ast).GetSecond();
+        if (!Is<Cell>(first) && !Is<Cell>(second) && second) {
+            Serialize(first, ans);
+            ans += " . ";
+            Serialize(second, ans);
+            return;
+        }
+        if (Is<Cell>(first) || !first) {
+            ans += '(';
+            Serialize(first, ans);
+            ans += ')';
+        } else {
+            Serialize(first, ans);
+        }
+        if (!second) {
+            return;
+        }
+        ans += ' ';
+        ast = second;
+    }
     if (Is<Number>(ast)) {
-        ans += std::to_string(As<Number>(ast)->GetValue());
+        ans += std::to_string(Number::GetValue(ast));
     } else if (Is<Boolean>(ast)) {
-        if (As<Boolean>(ast)->GetValue()) {
+        if (Boolean::GetValue(ast)) {
             ans += "#t";
         } else {
             ans += "#f";
         }
     } else if (Is<Symbol>(ast)) {
         ans += As<Symbol>(ast)->GetName();
-    } else if (Is<Cell>(ast)) {
-        std::shared_ptr<Object> first = As<Cell>(ast)->GetFirst();
-        std::shared_ptr<Object> second = As<Cell>(ast)->GetSecond();
-        if (!Is<Cell>(first) && !Is<Cell>(second) && second) {
-            Serialize(first, ans);
-            ans += " . ";
-            Serialize(second, ans);
-        } else {
-            if (Is<Cell>(first) || !first) {
-                ans += '(';
-                Serialize(first, ans);
-                ans += ')';
+    }
+}
+
+std::string Interpreter::RunCanonical(std::string_view input) {
+    std::optional<RunArena> arena;
+    if (use_arena_) {
+        arena.emplace(&arena_allocation_count_);
+    }
+    std::string out;
+    SerializeCanonical(Unpack<Object>(ReadCanonical(input)), out);
+    return out;
+}
+
+// A quoted datum is read as a cell holding the Quote object and the datum.
+static bool IsQuoted(const Cell* cell) {
+    return Is<Quote>(cell->GetFirst());
+}
+
+void Interpreter::SerializeCanonical(Ref<Object> ast, std::string& out) {
+    // Parts left to write, the next one last. A tail is the rest of a list being written, so
+    // a long list takes one entry rather than one per element. The parts are owned by `ast`.
+    struct Part {
+        Object* object;
+        bool is_tail;
+    };
+    std::vector<Part> parts{{ast.get(), false}};
+    while (!parts.empty()) {
+        auto [object, is_tail] = parts.back();
+        parts.pop_back();
+        auto* cell = TryAs<Cell>(object);
+        if (is_tail) {
+            if (!object) {
+                out += ')';
+            } else if (cell && !IsQuoted(cell)) {
+                parts.push_back({cell->GetSecond().get(), true});
+                parts.push_back({cell->GetFirst().get(), false});
             } else {
-                Serialize(first, ans);
+                out += '.';
+                parts.push_back({nullptr, true});
+                parts.push_back({object, false});
             }
-            if (second) {
-                ans += ' ';
-                Serialize(second, ans);
+        } else if (cell) {
+            if (IsQuoted(cell)) {
+                out += '\'';
+                parts.push_back({cell->GetSecond().get(), false});
+            } else {
+                out += '(';
+                parts.push_back({cell->GetSecond().get(), true});
+                parts.push_back({cell->GetFirst().get(), false});
+            }
+        } else if (!object) {
+            out += "()";
+        } else if (Is<Number>(object)) {
+            auto bits = static_cast<uint32_t>(Number::GetValue(object));
+            out += 'i';
+            for (size_t i = 0; i < 4; ++i) {
+                out += static_cast<char>(bits >> (8 * i));
             }
+        } else if (Is<Boolean>(object)) {
+            out += Boolean::GetValue(object) ? 't' : 'f';
+        } else if (auto* symbol = TryAs<Symbol>(object)) {
+            const std::string& name = symbol->GetName();
+            out += std::to_string(name.size());
+            out += ':';
+            out += name;
+        } else {
+            throw RuntimeError("object has no canonical encoding");
         }
     }
 }
 
-std::string Interpreter::PerformOutput(std::shared_ptr<Object> ast) {
+std::string Interpreter::PerformOutput(Ref<Object> ast) {
     std::string ans;
     if (Is<Cell>(ast) || ast == nullptr) {
         ans += '(';
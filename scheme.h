@@ -1,12 +1,48 @@
 #pragma once
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <parser.h>
 #include <helpers.h>
 
 class Interpreter {
 public:
-    std::string Run(const std::string& input);
-    std::string PerformOutput(std::shared_ptr<Object> ast);
-    void Serialize(std::shared_ptr<Object> ast, std::string& ans);
+    // With `use_arena`, objects created during each Run are allocated from a RunArena that is
+    // released when Run returns.
+    explicit Interpreter(bool use_arena = false) : use_arena_(use_arena) {
+    }
+
+    std::string Run(std::string_view input);
+    // Maps the file at `path` read-only and runs it without copying it into memory.
+    std::string RunFile(const std::string& path);
+    // Reads and evaluates every top-level form of `program` in order and returns their results.
+    // Forms are read on a separate thread, so reading form k + 1 overlaps evaluating form k.
+    // Errors are thrown when the failing form is reached; earlier forms are still evaluated.
+    std::vector<std::string> RunProgram(std::string_view program);
+    // Like RunProgram on the file at `path`, but loads its parsed forms from a fasl file in
+    // `cache_dir` when one matches the file contents, and writes one otherwise.
+    std::vector<std::string> RunCachedFile(const std::string& path, const std::string& cache_dir);
+    // Like RunProgram on the file at `path`, but reads it with ReadLazy: nested lists are only
+    // read once evaluation reaches them, so code that is never evaluated is never fully read.
+    std::vector<std::string> RunLazyFile(const std::string& path);
+    // Evaluates a datum in the canonical binary encoding (see ReadCanonical) and returns the
+    // result in the same encoding.
+    std::string RunCanonical(std::string_view input);
+    std::string PerformOutput(Ref<Object> ast);
+    void Serialize(Ref<Object> ast, std::string& ans);
+    // Appends the canonical binary encoding of `ast` to `out`. Throws RuntimeError for objects
+    // that have no encoding, such as builtins.
+    void SerializeCanonical(Ref<Object> ast, std::string& out);
+
+    // Number of object allocations served by run arenas instead of the heap so far.
+    size_t GetArenaAllocationCount() const {
+        return arena_allocation_count_;
+    }
+
+private:
+    std::string Evaluate(Ref<Object> ast);
+
+private:
+    bool use_arena_;
+    size_t arena_allocation_count_ = 0;
 };
@@ -0,0 +1,157 @@
+#include <slab.h>
+
+#include <mutex>
+#include <vector>
+
+static constexpr size_t kClassCount = SlabPool::kMaxBlockSize / SlabPool::kGranularity;
+static constexpr size_t kSlabSize = 64 << 10;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+static size_t SizeClass(size_t size) {
+    return (size + SlabPool::kGranularity - 1) / SlabPool::kGranularity - 1;
+}
+
+static size_t BlockSize(size_t size_class) {
+    return (size_class + 1) * SlabPool::kGranularity;
+}
+
+// Blocks per batch moved between a thread and the depot: one slab's worth.
+static size_t BatchSize(size_t size_class) {
+    return kSlabSize / BlockSize(size_class);
+}
+
+// A chain of free blocks and its length.
+struct FreeBatch {
+    FreeBlock* head;
+    size_t count;
+};
+
+// Slabs and the free blocks returned by threads, shared by all threads. It is never destroyed,
+// since objects may still be released after static destructors have run.
+struct Depot {
+    std::mutex mutex;
+    std::vector<FreeBatch> free[kClassCount];
+    std::vector<void*> slabs;
+};
+
+static Depot& GetDepot() {
+    static Depot* depot = new Depot;
+    return *depot;
+}
+
+static void ReturnToDepot(size_t size_class, FreeBatch batch) {
+    Depot& depot = GetDepot();
+    std::lock_guard lock{depot.mutex};
+    depot.free[size_class].push_back(batch);
+}
+
+// Trivially destructible, so it stays usable while the thread is exiting.
+struct ThreadFreeLists {
+    FreeBlock* free[kClassCount];
+    size_t count[kClassCount];
+    bool is_exiting;
+};
+
+static thread_local ThreadFreeLists free_lists;
+
+// Hands the free lists of an exiting thread over to the depot. From then on the thread frees
+// straight into the depot.
+struct ThreadExitFlush {
+    ~ThreadExitFlush() {
+        for (size_t i = 0; i < kClassCount; ++i) {
+            if (free_lists.free[i]) {
+                ReturnToDepot(i, {free_lists.free[i], free_lists.count[i]});
+                free_lists.free[i] = nullptr;
+                free_lists.count[i] = 0;
+            }
+        }
+        free_lists.is_exiting = true;
+    }
+};
+
+static thread_local ThreadExitFlush exit_flush;
+
+// Takes a batch of free blocks of the class from the depot, or carves a new slab into blocks.
+static FreeBatch Refill(size_t size_class) {
+    Depot& depot = GetDepot();
+    std::lock_guard lock{depot.mutex};
+    if (!depot.free[size_class].empty()) {
+        FreeBatch batch = depot.free[size_class].back();
+        depot.free[size_class].pop_back();
+        return batch;
+    }
+    char* slab = static_cast<char*>(::operator new(kSlabSize));
+    depot.slabs.push_back(slab);
+    size_t block_size = BlockSize(size_class);
+    FreeBlock* blocks = nullptr;
+    for (size_t offset = BatchSize(size_class) * block_size; offset > 0; offset -= block_size) {
+        auto* block = reinterpret_cast<FreeBlock*>(slab + offset - block_size);
+        block->next = blocks;
+        blocks = block;
+    }
+    return {blocks, BatchSize(size_class)};
+}
+
+void* SlabPool::Allocate(size_t size) {
+    size_t size_class = SizeClass(size);
+    FreeBlock*& head = free_lists.free[size_class];
+    if (!head) {
+        if (free_lists.is_exiting) {
+            return ::operator new(BlockSize(size_class));
+        }
+        // Registers the exit flush of this thread.
+        (void)&exit_flush;
+        FreeBatch batch = Refill(size_class);
+        head = batch.head;
+        free_lists.count[size_class] = batch.count;
+    }
+    FreeBlock* block = head;
+    head = block->next;
+    --free_lists.count[size_class];
+    return block;
+}
+
+void SlabPool::Deallocate(void* block, size_t size) {
+    size_t size_class = SizeClass(size);
+    auto* free_block = static_cast<FreeBlock*>(block);
+    if (free_lists.is_exiting) {
+        Depot& depot = GetDepot();
+        std::lock_guard lock{depot.mutex};
+        std::vector<FreeBatch>& batches = depot.free[size_class];
+        if (batches.empty()) {
+            batches.push_back({nullptr, 0});
+        }
+        free_block->next = batches.back().head;
+        batches.back() = {free_block, batches.back().count + 1};
+        return;
+    }
+    FreeBlock*& head = free_lists.free[size_class];
+    if (!head) {
+        // A thread may free blocks without ever allocating any; they must still reach the depot
+        // when it exits.
+        (void)&exit_flush;
+    }
+    free_block->next = head;
+    head = free_block;
+    size_t& count = free_lists.count[size_class];
+    if (++count > 2 * BatchSize(size_class)) {
+        // Keeps the blocks freed last, which are the likeliest to be in cache, and returns the
+        // rest.
+        FreeBlock* last_kept = head;
+        for (size_t i = 1; i < BatchSize(size_class); ++i) {
+            last_kept = last_kept->next;
+        }
+        ReturnToDepot(size_class, {last_kept->next, count - BatchSize(size_class)});
+        last_kept->next = nullptr;
+        count = BatchSize(size_class);
+    }
+}
+
+size_t SlabPool::GetSlabBytes() {
+    Depot& depot = GetDepot();
+    std::lock_guard lock{depot.mutex};
+    return depot.slabs.size() * kSlabSize;
+}
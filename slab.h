@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// Size-class allocator for the small fixed-size blocks that objects live in. Blocks are carved
+// from 64 KiB slabs and recycled through free lists kept per thread and per size class, so
+// threads never contend on it; only moving a slab's worth of blocks between a thread and the
+// shared depot takes a lock. A block may be freed on another thread than the one that allocated
+// it: it then joins that thread's lists, and once those hold more than two slabs' worth, one
+// slab's worth goes back to the depot for any thread to reuse. Slab memory is reused but never
+// returned to the system.
+class SlabPool {
+public:
+    static constexpr size_t kGranularity = 16;
+    static constexpr size_t kMaxBlockSize = 128;
+
+    // `size` must be at most kMaxBlockSize.
+    static void* Allocate(size_t size);
+
+    static void Deallocate(void* block, size_t size);
+
+    // Bytes of slabs taken from the system so far, by all threads.
+    static size_t GetSlabBytes();
+};
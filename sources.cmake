@@ -1,6 +1,16 @@
 add_library(scheme_basic
         tokenizer.cpp
+        structural_index.cpp
+        mapped_file.cpp
+        slab.cpp
+        ref.cpp
+        arena.cpp
+        collector.cpp
+        nursery.cpp
+        fasl.cpp
+        hash_cons.cpp
         parser.cpp
+        cons_heap.cpp
         scheme.cpp
         helpers.cpp
         object.cpp
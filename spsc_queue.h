@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring buffer. Push blocks while the queue is full and
+// Pop while it is empty. The consumer may Close the queue to tell the producer to stop: pending
+// items are dropped and every later Push returns false.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots_(capacity) {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool Push(T item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            size_t head = head_.load(std::memory_order_acquire);
+            if (tail - head < slots_.size()) {
+                break;
+            }
+            head_.wait(head, std::memory_order_acquire);
+        }
+        slots_[tail % slots_.size()] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        tail_.notify_one();
+        return true;
+    }
+
+    T Pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        while (tail == head) {
+            tail_.wait(tail, std::memory_order_acquire);
+            tail = tail_.load(std::memory_order_acquire);
+        }
+        T item = std::move(slots_[head % slots_.size()]);
+        head_.store(head + 1, std::memory_order_release);
+        head_.notify_one();
+        return item;
+    }
+
+    // Consumer side only. Moving head_ up to tail_ wakes a producer blocked on a full queue.
+    void Close() {
+        closed_.store(true, std::memory_order_release);
+        head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+        head_.notify_one();
+    }
+
+private:
+    std::vector<T> slots_;
+    std::atomic<size_t> head_ = 0;
+    std::atomic<size_t> tail_ = 0;
+    std::atomic<bool> closed_ = false;
+};
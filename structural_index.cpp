@@ -0,0 +1,124 @@
+#include <structural_index.h>
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SCHEME_X86_SIMD
+#endif
+
+static constexpr size_t kBlockSize = 64;
+
+// Bit i of `spaces` / `structurals` describes byte i of a 64-byte block.
+struct BlockMasks {
+    uint64_t spaces;
+    uint64_t structurals;
+};
+
+[[maybe_unused]] static BlockMasks ClassifyBlockScalar(const char* block) {
+    BlockMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; ++i) {
+        char s = block[i];
+        if (s == ' ' || s == '\n') {
+            masks.spaces |= uint64_t{1} << i;
+        } else if (s == '(' || s == ')' || s == '\'' || s == '.') {
+            masks.structurals |= uint64_t{1} << i;
+        }
+    }
+    return masks;
+}
+
+#ifdef SCHEME_X86_SIMD
+static BlockMasks ClassifyBlockSSE2(const char* block) {
+    BlockMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('(')),
+                                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(')')));
+        __m128i marks = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\'')),
+                                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')));
+        auto space_bits = static_cast<uint16_t>(_mm_movemask_epi8(spaces));
+        auto structural_bits = static_cast<uint16_t>(_mm_movemask_epi8(_mm_or_si128(brackets, marks)));
+        masks.spaces |= uint64_t{space_bits} << i;
+        masks.structurals |= uint64_t{structural_bits} << i;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2"))) static BlockMasks ClassifyBlockAVX2(const char* block) {
+    BlockMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        __m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                                         _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        __m256i brackets = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('(')),
+                                           _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(')')));
+        __m256i marks = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\'')),
+                                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.')));
+        auto space_bits = static_cast<uint32_t>(_mm256_movemask_epi8(spaces));
+        auto structural_bits =
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(brackets, marks)));
+        masks.spaces |= uint64_t{space_bits} << i;
+        masks.structurals |= uint64_t{structural_bits} << i;
+    }
+    return masks;
+}
+#endif
+
+using ClassifyBlockFunc = BlockMasks (*)(const char*);
+
+static ClassifyBlockFunc SelectClassifyBlock() {
+#ifdef SCHEME_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return ClassifyBlockAVX2;
+    }
+    return ClassifyBlockSSE2;
+#else
+    return ClassifyBlockScalar;
+#endif
+}
+
+// Appends the token starts of one block. `previous_boundary` carries whether the last byte of
+// the previous block was a space or a structural byte.
+static void AppendStarts(BlockMasks masks, uint32_t offset, uint64_t& previous_boundary,
+                         std::vector<uint32_t>& index) {
+    uint64_t boundaries = masks.spaces | masks.structurals;
+    uint64_t after_boundary = (boundaries << 1) | previous_boundary;
+    previous_boundary = boundaries >> 63;
+    uint64_t starts = ~masks.spaces & (masks.structurals | after_boundary);
+    while (starts) {
+        index.push_back(offset + std::countr_zero(starts));
+        starts &= starts - 1;
+    }
+}
+
+std::vector<uint32_t> BuildStructuralIndex(std::string_view input) {
+    std::vector<uint32_t> index;
+    index.reserve(input.size() / 4);
+    BuildStructuralIndex(input, 0, input.size(), index);
+    return index;
+}
+
+void BuildStructuralIndex(std::string_view input, size_t begin, size_t end,
+                          std::vector<uint32_t>& index) {
+    static const ClassifyBlockFunc kClassifyBlock = SelectClassifyBlock();
+    index.clear();
+    uint64_t previous_boundary = 1;
+    if (begin > 0) {
+        char s = input[begin - 1];
+        previous_boundary = s == ' ' || s == '\n' || s == '(' || s == ')' || s == '\'' || s == '.';
+    }
+    size_t offset = begin;
+    for (; offset + kBlockSize <= end; offset += kBlockSize) {
+        AppendStarts(kClassifyBlock(input.data() + offset), offset, previous_boundary, index);
+    }
+    if (offset < end) {
+        char tail[kBlockSize];
+        std::memset(tail, ' ', kBlockSize);
+        std::memcpy(tail, input.data() + offset, end - offset);
+        AppendStarts(kClassifyBlock(tail), offset, previous_boundary, index);
+    }
+}
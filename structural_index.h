@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Offsets of every byte a token can start at: each of `(`, `)`, `'`, `.` and the first byte of
+// every run of other non-space bytes. Spaces and newlines never appear in the index, so a
+// tokenizer can jump over them instead of classifying them one by one.
+//
+// The index is built 64 bytes at a time with SSE2 or AVX2 when the CPU has them.
+std::vector<uint32_t> BuildStructuralIndex(std::string_view input);
+
+// Replaces the contents of `index` with the offsets in [begin, end) only, so that a long input
+// can be indexed a window at a time.
+void BuildStructuralIndex(std::string_view input, size_t begin, size_t end,
+                          std::vector<uint32_t>& index);
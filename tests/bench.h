@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Runs `body` `iterations` times and prints the throughput over `bytes` bytes per iteration.
+template <typename Body>
+double MeasureThroughput(const std::string& name, size_t bytes, int iterations, Body&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double mb_per_sec = static_cast<double>(bytes) * iterations / elapsed.count() / (1 << 20);
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << mb_per_sec << " MB/s" << std::endl;
+    return mb_per_sec;
+}
@@ -0,0 +1,645 @@
+#include <catch.hpp>
+
+#include <collector.h>
+#include <cons_heap.h>
+#include <fasl.h>
+#include <nursery.h>
+#include <parser.h>
+#include <scheme.h>
+
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+// A tree of lists, each holding up to `width` atoms or sublists, `depth` levels deep.
+void GenerateTree(size_t width, size_t depth, std::mt19937* rng, std::string* out) {
+    static const char* kAtoms[] = {"x1", "zog-zog?", "12345", "-7", "+", "#t", "#f", "<=", "cons"};
+    *out += '(';
+    for (size_t i = 0; i < width; ++i) {
+        if (depth > 0 && (*rng)() % 4 == 0) {
+            GenerateTree(width, depth - 1, rng, out);
+        } else {
+            *out += kAtoms[(*rng)() % std::size(kAtoms)];
+        }
+        *out += ' ';
+    }
+    *out += ')';
+}
+
+TEST_CASE("Reader throughput") {
+    std::mt19937 rng{42};
+    std::string input = "'(";
+    while (input.size() < (4 << 20)) {
+        GenerateTree(16, 6, &rng, &input);
+        input += '\n';
+    }
+    input += ')';
+    MeasureThroughput("Read, Tokenizer variant tokens", input.size(), 5, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        REQUIRE(Read(&tokenizer));
+    });
+    MeasureThroughput("Tokenizer::TokenizeAll", input.size(), 5, [&] {
+        REQUIRE(Tokenizer::TokenizeAll(input).Size() > 0);
+    });
+    MeasureThroughput("TokenizeAll + Read, token buffer", input.size(), 5, [&] {
+        REQUIRE(Read(Tokenizer::TokenizeAll(input)));
+    });
+}
+
+TEST_CASE("Text and canonical round trips") {
+    std::mt19937 rng{42};
+    std::string text = "'(";
+    while (text.size() < (4 << 20)) {
+        GenerateTree(16, 6, &rng, &text);
+        text += '\n';
+    }
+    text += ')';
+    Interpreter interpreter;
+    std::string binary;
+    {
+        Tokenizer tokenizer{std::string_view{text}};
+        interpreter.SerializeCanonical(Read(&tokenizer), binary);
+    }
+    std::cout << "text " << text.size() / 1024 << " KiB, canonical " << binary.size() / 1024
+              << " KiB" << std::endl;
+    MeasureThroughput("Run, text in and out", text.size(), 5,
+                      [&] { REQUIRE(!interpreter.Run(text).empty()); });
+    MeasureThroughput("RunCanonical, binary in and out", text.size(), 5,
+                      [&] { REQUIRE(!interpreter.RunCanonical(binary).empty()); });
+}
+
+// Counts the symbols of a datum, as a filter over large data would.
+class SymbolCounter : public DatumHandler {
+public:
+    void OnSymbol(std::string_view) override {
+        ++count;
+    }
+
+    size_t count = 0;
+};
+
+TEST_CASE("Event reader throughput") {
+    std::mt19937 rng{42};
+    std::string input = "'(";
+    while (input.size() < (4 << 20)) {
+        GenerateTree(16, 6, &rng, &input);
+        input += '\n';
+    }
+    input += ')';
+    size_t symbols = 0;
+    MeasureThroughput("Read + walk for symbols", input.size(), 5, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        std::vector<Ref<Object>> pending{Read(&tokenizer)};
+        symbols = 0;
+        while (!pending.empty()) {
+            auto datum = std::move(pending.back());
+            pending.pop_back();
+            if (Is<Cell>(datum)) {
+                pending.push_back(As<Cell>(datum)->GetFirst());
+                pending.push_back(As<Cell>(datum)->GetSecond());
+            } else {
+                symbols += Is<Symbol>(datum);
+            }
+        }
+    });
+    MeasureThroughput("ReadEvents, counting symbols", input.size(), 5, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        SymbolCounter counter;
+        ReadEvents(&tokenizer, &counter);
+        REQUIRE(counter.count == symbols);
+    });
+}
+
+TEST_CASE("Reader scaling on long lists") {
+    for (size_t length : {100'000, 1'000'000, 10'000'000}) {
+        std::string input = "'(";
+        for (size_t i = 0; i < length; ++i) {
+            input += std::to_string(i % 1000);
+            input += ' ';
+        }
+        input += ')';
+        MeasureThroughput("Read, " + std::to_string(length) + "-element list", input.size(), 1,
+                          [&] {
+                              Tokenizer tokenizer{std::string_view{input}};
+                              REQUIRE(Read(&tokenizer));
+                          });
+    }
+}
+
+TEST_CASE("Run arena throughput") {
+    const std::string input = "(+ 1 (* 2 3) (- 4 5) (max 1 2 (abs -3)) (car '(1 2 3 4)))";
+    constexpr int kRuns = 200'000;
+    MeasureThroughput("Interpreter::Run, heap", input.size() * kRuns, 1, [&] {
+        Interpreter interpreter;
+        for (int i = 0; i < kRuns; ++i) {
+            REQUIRE(interpreter.Run(input) == "10");
+        }
+    });
+    Interpreter interpreter{true};
+    MeasureThroughput("Interpreter::Run, run arena", input.size() * kRuns, 1, [&] {
+        for (int i = 0; i < kRuns; ++i) {
+            REQUIRE(interpreter.Run(input) == "10");
+        }
+    });
+    std::cout << "arena allocations per run: " << interpreter.GetArenaAllocationCount() / kRuns
+              << std::endl;
+}
+
+TEST_CASE("Program throughput") {
+    std::string program;
+    std::vector<std::string> forms;
+    for (int i = 0; i < 100'000; ++i) {
+        forms.push_back("(+ " + std::to_string(i) + " (* 2 3) (max 1 (abs -" + std::to_string(i) +
+                        ")) (car '(1 2 3 4 5 6 7 8)))");
+        program += forms.back() + '\n';
+    }
+    // RunProgram goes first: once a process has started a thread, malloc switches to its
+    // atomic paths, which would otherwise penalize it alone.
+    Interpreter interpreter;
+    MeasureThroughput("Interpreter::RunProgram", program.size(), 1, [&] {
+        REQUIRE(interpreter.RunProgram(program).size() == forms.size());
+    });
+    MeasureThroughput("Interpreter::Run per form", program.size(), 1, [&] {
+        for (const auto& form : forms) {
+            interpreter.Run(form);
+        }
+    });
+}
+
+TEST_CASE("Incremental reader throughput") {
+    // One large datum arriving in small chunks, as from a socket.
+    std::mt19937 rng{42};
+    std::string input = "(";
+    while (input.size() < (4 << 20)) {
+        GenerateTree(8, 4, &rng, &input);
+        input += '\n';
+    }
+    input += ")";
+    MeasureThroughput("Read, whole input", input.size(), 3, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        REQUIRE(Read(&tokenizer));
+    });
+    MeasureThroughput("IncrementalReader, 64-byte chunks", input.size(), 3, [&] {
+        IncrementalReader reader;
+        for (size_t i = 0; i < input.size(); i += 64) {
+            reader.Feed(std::string_view{input}.substr(i, 64));
+        }
+        reader.Finish();
+        REQUIRE(reader.HasDatum());
+    });
+}
+
+TEST_CASE("Lazy reader throughput") {
+    // Forms whose bulk sits behind a short-circuited (and #f ...), as in rarely taken branches.
+    std::mt19937 rng{42};
+    std::string program;
+    for (int i = 0; i < 20'000; ++i) {
+        program += "(and #f ";
+        GenerateTree(8, 3, &rng, &program);
+        program += ")\n";
+    }
+    Interpreter interpreter;
+    MeasureThroughput("ReadNext, all forms", program.size(), 3, [&] {
+        std::vector<Ref<Object>> datums;
+        Tokenizer tokenizer{std::string_view{program}};
+        while (!tokenizer.IsEnd()) {
+            datums.push_back(ReadNext(&tokenizer));
+        }
+    });
+    MeasureThroughput("ReadLazy, all forms", program.size(), 3, [&] {
+        REQUIRE(ReadLazy(program, nullptr).size() == 20'000);
+    });
+    MeasureThroughput("ReadNext + evaluate", program.size(), 3, [&] {
+        Tokenizer tokenizer{std::string_view{program}};
+        while (!tokenizer.IsEnd()) {
+            REQUIRE(interpreter.PerformOutput(Unpack(ReadNext(&tokenizer))) == "#f");
+        }
+    });
+    MeasureThroughput("ReadLazy + evaluate", program.size(), 3, [&] {
+        for (auto& form : ReadLazy(program, nullptr)) {
+            REQUIRE(interpreter.PerformOutput(Unpack(std::move(form))) == "#f");
+        }
+    });
+}
+
+TEST_CASE("Arithmetic evaluation throughput") {
+    std::string program;
+    for (int i = 0; i < 10'000; ++i) {
+        std::string n = std::to_string(i % 500);
+        program += "(+ (* " + n + " 2) (- 100 (abs -3)) (max 1 " + n + " 3) (min 4 (+ 1 2)))\n";
+        program += "(and (< (+ " + n + " 1) (* " + n + " 3 1)) (or #f (= (- 0 " + n + ") (* -1 " +
+                   n + "))))\n";
+    }
+    std::vector<Ref<Object>> forms;
+    Tokenizer tokenizer{std::string_view{program}};
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(ReadNext(&tokenizer));
+    }
+    MeasureThroughput("Unpack, arithmetic forms", program.size(), 5, [&] {
+        for (const auto& form : forms) {
+            REQUIRE(Unpack(form));
+        }
+    });
+}
+
+TEST_CASE("Type check throughput") {
+    std::string list = "'(";
+    for (int i = 0; i < 1000; ++i) {
+        list += std::to_string(i % 100) + (i % 3 ? " x " : " ");
+    }
+    list += ')';
+    std::string predicates;
+    for (const char* predicate : {"list?", "pair?", "null?"}) {
+        predicates += std::string("(") + predicate + ' ' + list + ")\n";
+    }
+    std::vector<Ref<Object>> forms;
+    Tokenizer tokenizer{std::string_view{predicates}};
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(ReadNext(&tokenizer));
+    }
+    MeasureThroughput("Unpack, list predicates", predicates.size(), 2000, [&] {
+        for (const auto& form : forms) {
+            REQUIRE(Unpack(form));
+        }
+    });
+
+    std::vector<Ref<Object>> objects;
+    for (const auto& form : forms) {
+        auto quoted = As<Cell>(As<Cell>(form)->GetSecond())->GetFirst();
+        for (auto rest = As<Cell>(quoted)->GetSecond(); rest; rest = As<Cell>(rest)->GetSecond()) {
+            objects.push_back(rest);
+            objects.push_back(As<Cell>(rest)->GetFirst());
+        }
+    }
+    size_t cells = 0;
+    MeasureThroughput("Is<T>, 8 bytes per object", objects.size() * sizeof(void*), 20000, [&] {
+        for (const auto& object : objects) {
+            cells += Is<Cell>(object) + Is<Number>(object) * 2 + Is<Symbol>(object) * 3;
+        }
+    });
+    REQUIRE(cells > 0);
+}
+
+TEST_CASE("Reference count traffic") {
+    // Pointer copies pay for atomic counting only once the process has started a thread, so
+    // start one; the interpreter itself still runs on this one.
+    std::jthread{[] {}}.join();
+
+    Ref<Object> list;
+    for (int i = 0; i < 100'000; ++i) {
+        list = MakeObject<Cell>(Number::Make(i % 100), std::move(list));
+    }
+    size_t sum = 0;
+    MeasureThroughput("owning list walk, 8 bytes per cell", 100'000 * sizeof(void*), 200, [&] {
+        for (auto rest = list; rest; rest = AsRef<Cell>(rest).GetSecond()) {
+            auto first = AsRef<Cell>(rest).GetFirst();
+            sum += Number::GetValue(first);
+        }
+    });
+    REQUIRE(sum > 0);
+
+    std::string long_list = "(list?";
+    for (int i = 0; i < 1000; ++i) {
+        long_list += " '(" + std::to_string(i) + " x)";
+    }
+    long_list += ')';
+    Tokenizer list_tokenizer{std::string_view{long_list}};
+    auto list_form = Read(&list_tokenizer);
+    MeasureThroughput("Unpack, 1000 quoted arguments", long_list.size(), 2000,
+                      [&] { REQUIRE(Unpack(list_form)); });
+
+    std::mt19937 rng{7};
+    std::string source;
+    GenerateTree(8, 6, &rng, &source);
+    Tokenizer tokenizer{std::string_view{source}};
+    auto tree = Read(&tokenizer);
+    Interpreter interpreter;
+    MeasureThroughput("Serialize", source.size(), 200, [&] {
+        std::string out;
+        interpreter.Serialize(tree, out);
+        REQUIRE(!out.empty());
+    });
+}
+
+TEST_CASE("Cons heap footprint on 10M-element lists") {
+    constexpr size_t kLength = 10'000'000;
+    std::string input = "(";
+    for (size_t i = 0; i < kLength; ++i) {
+        input += std::to_string(i % 1000);
+        input += ' ';
+    }
+    input += ')';
+    auto print_footprint = [](const std::string& name, size_t bytes) {
+        std::cout << std::left << std::setw(48) << name << std::right << std::setw(10)
+                  << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / kLength
+                  << " B/pair" << std::endl;
+    };
+
+    // The reader puts the cells of a list side by side in one block; the numbers are all shared,
+    // so the cells are everything.
+    Ref<Object> cells;
+    MeasureThroughput("Read into cells", input.size(), 1, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        cells = Read(&tokenizer);
+    });
+    print_footprint("cells", kLength * sizeof(Cell));
+
+    ConsHeap heap;
+    ConsHeap::Value pairs = ConsHeap::kNil;
+    MeasureThroughput("ConsHeap::Read", input.size(), 1, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        pairs = heap.Read(&tokenizer);
+    });
+    REQUIRE(heap.GetPairCount() == kLength);
+    print_footprint("ConsHeap, pairs", heap.GetPairCount() * 2 * sizeof(ConsHeap::Value));
+    // With the slack left by growing the arrays.
+    print_footprint("ConsHeap, allocated", heap.GetMemoryUsage());
+
+    Ref<Object> list_ref = MakeObject<Cell>(
+            SymbolTable::Instantiate().Intern("list-ref"),
+            MakeObject<Cell>(MakeObject<Cell>(MakeObject<Quote>(), cells),
+                             MakeObject<Cell>(Number::Make(kLength - 1), nullptr)));
+    size_t walked = kLength * sizeof(void*);
+    MeasureThroughput("list-ref of the last element, cells", walked, 5,
+                      [&] { REQUIRE(Number::GetValue(Unpack(list_ref)) == 999); });
+    MeasureThroughput("ListRef of the last element, ConsHeap", walked, 5,
+                      [&] { REQUIRE(heap.ListRef(pairs, kLength - 1) == heap.MakeNumber(999)); });
+    MeasureThroughput("list?, cells", walked, 5, [&] { REQUIRE(ListFunc{}(cells)); });
+    MeasureThroughput("IsList, ConsHeap", walked, 5, [&] { REQUIRE(heap.IsList(pairs)); });
+    // The output has no space before the closing bracket.
+    size_t output_size = input.size() - 1;
+    Interpreter interpreter;
+    MeasureThroughput("PerformOutput, cells", input.size(), 1,
+                      [&] { REQUIRE(interpreter.PerformOutput(cells).size() == output_size); });
+    MeasureThroughput("ToString, ConsHeap", input.size(), 1,
+                      [&] { REQUIRE(heap.ToString(pairs).size() == output_size); });
+}
+
+TEST_CASE("List indexing throughput") {
+    std::string elements;
+    for (int i = 0; i < 1000; ++i) {
+        elements += ' ' + std::to_string(i);
+    }
+    std::string program;
+    for (int i = 0; i < 1000; i += 10) {
+        program += "(list-ref '(" + elements + ") " + std::to_string(i) + ")\n";
+        program += "(list-tail '(" + elements + ") " + std::to_string(i) + ")\n";
+    }
+    std::vector<Ref<Object>> forms;
+    Tokenizer tokenizer{std::string_view{program}};
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(ReadNext(&tokenizer));
+    }
+    MeasureThroughput("Unpack, list-ref and list-tail", program.size(), 50, [&] {
+        for (const auto& form : forms) {
+            REQUIRE(Unpack(form));
+        }
+    });
+
+    std::string make_list = "(list" + elements + ")";
+    Tokenizer list_tokenizer{std::string_view{make_list}};
+    auto list = Unpack(Read(&list_tokenizer));
+    int sum = 0;
+    MeasureThroughput("car walk over a list, 8 bytes per cell", 1000 * sizeof(void*), 20000, [&] {
+        for (Cell* cell = &AsRef<Cell>(list); cell; cell = TryAs<Cell>(cell->GetSecond().get())) {
+            sum += Number::GetValue(cell->GetFirst());
+        }
+    });
+    REQUIRE(sum > 0);
+}
+
+TEST_CASE("Sequential indexing of consed lists") {
+    // Built a cell at a time, as cons does, so no segment helps.
+    constexpr int kSize = 20'000;
+    Ref<Object> list;
+    for (int i = kSize; i-- > 0;) {
+        list = MakeObject<Cell>(Number::Make(i), std::move(list));
+    }
+    std::vector<Ref<Object>> args{MakeObject<Cell>(MakeObject<Quote>(), list), nullptr};
+    int64_t sum = 0;
+    MeasureThroughput("list-ref at 0, 1, 2, ..., 8 bytes per cell", kSize * sizeof(void*), 5, [&] {
+        for (int i = 0; i < kSize; ++i) {
+            args[1] = Number::Make(i);
+            sum += Number::GetValue(ListRef{}.Apply(args));
+        }
+    });
+    REQUIRE(sum > 0);
+
+    Ref<Object> other;
+    for (int i = kSize; i-- > 0;) {
+        other = MakeObject<Cell>(Number::Make(i), std::move(other));
+    }
+    std::vector<Ref<Object>> other_args{MakeObject<Cell>(MakeObject<Quote>(), other), nullptr};
+    MeasureThroughput("list-ref at 0, 1, 2, ... on two lists in turn", 2 * kSize * sizeof(void*), 5,
+                      [&] {
+                          for (int i = 0; i < kSize; ++i) {
+                              args[1] = Number::Make(i);
+                              other_args[1] = Number::Make(i);
+                              sum += Number::GetValue(ListRef{}.Apply(args));
+                              sum += Number::GetValue(ListRef{}.Apply(other_args));
+                          }
+                      });
+    REQUIRE(sum > 0);
+
+    Ref<Object> scratch = MakeObject<Cell>(nullptr, nullptr);
+    MeasureThroughput("list-ref at 0, 1, 2, ... while relinking another list", kSize * sizeof(void*),
+                      5, [&] {
+                          for (int i = 0; i < kSize; ++i) {
+                              args[1] = Number::Make(i);
+                              sum += Number::GetValue(ListRef{}.Apply(args));
+                              AsRef<Cell>(scratch).SetSecond(Number::Make(i));
+                          }
+                      });
+    REQUIRE(sum > 0);
+
+    std::vector<Ref<Object>> length_args{args[0]};
+    MeasureThroughput("length, 8 bytes per cell", kSize * sizeof(void*), 200, [&] {
+        REQUIRE(Number::GetValue(Length{}.Apply(length_args)) == kSize);
+        REQUIRE(ListFunc{}(list));
+    });
+}
+
+TEST_CASE("Cycle collector pauses") {
+    std::mt19937 rng{42};
+    std::string input = "'(";
+    while (input.size() < (4 << 20)) {
+        GenerateTree(16, 6, &rng, &input);
+        input += '\n';
+    }
+    input += ')';
+    MeasureThroughput("Read, untracked", input.size(), 3, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        REQUIRE(Read(&tokenizer));
+    });
+    CycleCollector collector;
+    MeasureThroughput("Read, tracked by a collector", input.size(), 3, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        REQUIRE(Read(&tokenizer));
+    });
+    // Garbage cycles among a live datum.
+    Tokenizer tokenizer{std::string_view{input}};
+    auto live = Read(&tokenizer);
+    for (int i = 0; i < 100'000; ++i) {
+        auto first = MakeObject<Cell>(Number::Make(i), nullptr);
+        first->SetSecond(MakeObject<Cell>(Number::Make(i), first));
+    }
+    collector.Collect();
+    const auto& stats = collector.GetStats();
+    std::cout << "tracked " << collector.GetTrackedCount() << " cells, " << stats.collections
+              << " collections (" << stats.young_collections << " young), max pause "
+              << std::chrono::duration_cast<std::chrono::microseconds>(stats.max_pause).count()
+              << " us, total "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(stats.total_pause).count()
+              << " ms, reclaimed " << stats.reclaimed_bytes / 1024 << " KiB" << std::endl;
+}
+
+TEST_CASE("Cons-heavy evaluation throughput") {
+    std::string long_list = "(list";
+    for (int i = 0; i < 1000; ++i) {
+        long_list += ' ' + std::to_string(i);
+    }
+    long_list += ')';
+    Tokenizer list_tokenizer{std::string_view{long_list}};
+    auto list_form = Read(&list_tokenizer);
+    MeasureThroughput("list of 1000 arguments", long_list.size(), 2000,
+                      [&] { REQUIRE(Unpack(list_form)); });
+
+    std::string conses;
+    for (int i = 0; i < 10'000; ++i) {
+        conses += "(cons " + std::to_string(i % 100) + " (list 1 2 3 4))\n";
+    }
+    std::vector<Ref<Object>> forms;
+    Tokenizer tokenizer{std::string_view{conses}};
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(ReadNext(&tokenizer));
+    }
+    MeasureThroughput("cons forms", conses.size(), 20, [&] {
+        for (const auto& form : forms) {
+            REQUIRE(Unpack(form));
+        }
+    });
+
+    // A chain built link by link, as a deep (cons 1 (cons 2 ...)) would be.
+    MeasureThroughput("cons chain of 1M cells", (1 << 20) * sizeof(Cell), 3, [&] {
+        Ref<Object> chain;
+        for (int i = 0; i < (1 << 20); ++i) {
+            chain = MakeObject<Cell>(Number::Make(i % 100), std::move(chain));
+        }
+    });
+
+    Nursery nursery;
+    MeasureThroughput("cons forms, cells from a nursery", conses.size(), 20, [&] {
+        for (const auto& form : forms) {
+            REQUIRE(Unpack(form));
+        }
+        nursery.Collect();
+    });
+    MeasureThroughput("cons chain of 1M cells from a nursery", (1 << 20) * sizeof(Cell), 3, [&] {
+        Ref<Object> chain;
+        for (int i = 0; i < (1 << 20); ++i) {
+            chain = MakeObject<Cell>(Number::Make(i % 100), std::move(chain));
+        }
+    });
+
+    // Promoted survivors are laid out in list order, while the young cells of a list built
+    // along with other cells are spread out.
+    auto holder = MakeHeapObject<Cell>(nullptr, nullptr);
+    std::vector<Ref<Object>> others;
+    for (int i = 0; i < 20'000; ++i) {
+        holder->SetSecond(MakeObject<Cell>(Number::Make(i % 100), holder->GetSecond()));
+        for (int j = 0; j < 3; ++j) {
+            others.push_back(MakeObject<Cell>(nullptr, nullptr));
+        }
+    }
+    int64_t sum = 0;
+    auto measure_walk = [&](const char* name) {
+        MeasureThroughput(name, 20'000 * sizeof(void*), 1000, [&] {
+            for (auto* cell = TryAs<Cell>(holder->GetSecond().get()); cell;
+                 cell = TryAs<Cell>(cell->GetSecond().get())) {
+                sum += Number::GetValue(cell->GetFirst());
+            }
+        });
+    };
+    measure_walk("car walk over a young cons list, 8 bytes per cell");
+    nursery.Collect();
+    measure_walk("car walk over the list promoted, 8 bytes per cell");
+    REQUIRE(sum > 0);
+}
+
+TEST_CASE("Parallel reader throughput") {
+    std::mt19937 rng{42};
+    std::string input;
+    while (input.size() < (64 << 20)) {
+        GenerateTree(8, 2, &rng, &input);
+        input += '\n';
+    }
+    size_t datums = 0;
+    for (size_t threads : {1, 2, 4, 8}) {
+        MeasureThroughput("ReadParallel, " + std::to_string(threads) + " threads", input.size(), 1,
+                          [&] {
+                              auto parsed = ReadParallel(input, threads);
+                              REQUIRE((datums == 0 || parsed.datums.size() == datums));
+                              datums = parsed.datums.size();
+                          });
+    }
+}
+
+TEST_CASE("Fasl load throughput") {
+    std::mt19937 rng{42};
+    std::string source;
+    while (source.size() < (16 << 20)) {
+        GenerateTree(8, 2, &rng, &source);
+        source += '\n';
+    }
+    auto cache_dir = (std::filesystem::temp_directory_path() / "scheme_fasl_bench").string();
+    std::filesystem::remove_all(cache_dir);
+    size_t datums = 0;
+    MeasureThroughput("Tokenizer + ReadNext", source.size(), 1, [&] {
+        std::vector<Ref<Object>> parsed;
+        Tokenizer tokenizer{std::string_view{source}};
+        while (!tokenizer.IsEnd()) {
+            parsed.push_back(ReadNext(&tokenizer));
+        }
+        datums = parsed.size();
+    });
+    MeasureThroughput("ReadCached, cold (parse + write)", source.size(), 1,
+                      [&] { REQUIRE(ReadCached(source, cache_dir).size() == datums); });
+    MeasureThroughput("ReadCached, warm (hash + load)", source.size(), 3,
+                      [&] { REQUIRE(ReadCached(source, cache_dir).size() == datums); });
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST_CASE("Hash-consing quoted data") {
+    std::mt19937 rng{42};
+    static const char* kFragments[] = {"(tag alpha #t)", "(port 8080)", "(retry 3 (backoff 2))",
+                                       "(owner ops-team)", "(tag beta #f)", "(limits (cpu 2) (mem 4))"};
+    std::string input;
+    for (int i = 0; i < 100'000; ++i) {
+        input += "'(entry";
+        for (int j = 0; j < 4; ++j) {
+            input += ' ';
+            input += kFragments[rng() % std::size(kFragments)];
+        }
+        input += ")\n";
+    }
+    MeasureThroughput("ReadNext, quoted config", input.size(), 1, [&] {
+        std::vector<Ref<Object>> datums;
+        Tokenizer tokenizer{std::string_view{input}};
+        while (!tokenizer.IsEnd()) {
+            datums.push_back(ReadNext(&tokenizer));
+        }
+    });
+    HashConsTable table;
+    MeasureThroughput("ReadNext, quoted config, hash-consed", input.size(), 1, [&] {
+        std::vector<Ref<Object>> datums;
+        Tokenizer tokenizer{std::string_view{input}};
+        while (!tokenizer.IsEnd()) {
+            datums.push_back(ReadNext(&tokenizer, &table));
+        }
+    });
+    std::cout << "shared objects: " << table.GetSharedObjectCount()
+              << ", saved: " << table.GetSavedBytes() / (1 << 20) << " MiB" << std::endl;
+}
@@ -0,0 +1,97 @@
+#include <catch.hpp>
+
+#include <tokenizer.h>
+#include <structural_index.h>
+
+#include <random>
+#include <sstream>
+
+#include "bench.h"
+
+std::string GenerateScript(size_t size) {
+    static const char* kAtoms[] = {"(", ")", "'", "list-ref", "x1", "zog-zog?", "12345", "-7",
+                                   "+", "#t", "#f", ".", "<=", "cons"};
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<size_t> pick(0, std::size(kAtoms) - 1);
+    std::string script;
+    while (script.size() < size) {
+        script += kAtoms[pick(rng)];
+        script += (rng() % 8 == 0) ? '\n' : ' ';
+    }
+    return script;
+}
+
+// One list nested `depth` levels deep, repeated until `size` bytes.
+std::string GenerateDeepInput(size_t size, size_t depth) {
+    std::string input;
+    while (input.size() < size) {
+        for (size_t i = 0; i < depth; ++i) {
+            input += "(node ";
+        }
+        input += "'leaf";
+        input.append(depth, ')');
+        input += '\n';
+    }
+    return input;
+}
+
+// Flat records of many short atoms separated by indentation, as in a data file.
+std::string GenerateWideInput(size_t size) {
+    std::mt19937 rng{7};
+    std::string input;
+    while (input.size() < size) {
+        input += "(record";
+        for (int i = 0; i < 16; ++i) {
+            input += "\n    ";
+            input += std::to_string(rng() % 100000);
+            input += (rng() % 2) ? " #t" : " field-name";
+        }
+        input += ")\n";
+    }
+    return input;
+}
+
+size_t CountTokens(Tokenizer& tokenizer) {
+    size_t count = 0;
+    while (!tokenizer.IsEnd()) {
+        ++count;
+        tokenizer.Next();
+    }
+    return count;
+}
+
+TEST_CASE("Tokenizer throughput") {
+    auto script = GenerateScript(1 << 20);
+    size_t tokens = 0;
+    MeasureThroughput("Tokenizer, istream", script.size(), 5, [&] {
+        std::stringstream ss{script};
+        Tokenizer tokenizer{&ss};
+        tokens = CountTokens(tokenizer);
+    });
+    MeasureThroughput("Tokenizer, string_view", script.size(), 5, [&] {
+        Tokenizer tokenizer{std::string_view{script}};
+        REQUIRE(CountTokens(tokenizer) == tokens);
+    });
+    REQUIRE(tokens > 0);
+}
+
+void BenchInput(const std::string& name, const std::string& input) {
+    size_t tokens = 0;
+    MeasureThroughput("Tokenizer, istream, " + name, input.size(), 5, [&] {
+        std::stringstream ss{input};
+        Tokenizer tokenizer{&ss};
+        tokens = CountTokens(tokenizer);
+    });
+    MeasureThroughput("BuildStructuralIndex, " + name, input.size(), 5, [&] {
+        REQUIRE(!BuildStructuralIndex(input).empty());
+    });
+    MeasureThroughput("Tokenizer, indexed string_view, " + name, input.size(), 5, [&] {
+        Tokenizer tokenizer{std::string_view{input}};
+        REQUIRE(CountTokens(tokenizer) == tokens);
+    });
+}
+
+TEST_CASE("Structural index throughput") {
+    BenchInput("deep", GenerateDeepInput(8 << 20, 500));
+    BenchInput("wide", GenerateWideInput(8 << 20));
+}
@@ -0,0 +1,168 @@
+#include <catch.hpp>
+
+#include <collector.h>
+#include <error.h>
+#include <scheme.h>
+
+// Stands in for a weak reference to a cell: the cell holds a probe in its car, which it releases
+// when it dies.
+class Watch {
+public:
+    Ref<Object> MakeProbe() {
+        *alive_ = true;
+        return MakeObject<Probe>(alive_);
+    }
+
+    bool expired() const {
+        return !*alive_;
+    }
+
+private:
+    class Probe : public Object {
+    public:
+        explicit Probe(std::shared_ptr<bool> alive) : alive_(std::move(alive)) {
+        }
+
+        ~Probe() override {
+            *alive_ = false;
+        }
+
+    private:
+        std::shared_ptr<bool> alive_;
+    };
+
+    std::shared_ptr<bool> alive_ = std::make_shared<bool>(false);
+};
+
+// Two cells pointing at each other, with no outside references left.
+static Watch MakeGarbageCycle() {
+    Watch watch;
+    auto first = MakeObject<Cell>(watch.MakeProbe(), nullptr);
+    auto second = MakeObject<Cell>(Number::Make(2), first);
+    first->SetSecond(second);
+    return watch;
+}
+
+TEST_CASE("Cycles are collected") {
+    CycleCollector collector{0};
+    REQUIRE(CycleCollector::Current() == &collector);
+    auto cycle = MakeGarbageCycle();
+    REQUIRE(!cycle.expired());
+    REQUIRE(collector.GetTrackedCount() == 2);
+
+    collector.Collect();
+    REQUIRE(cycle.expired());
+    REQUIRE(collector.GetTrackedCount() == 0);
+    const auto& stats = collector.GetStats();
+    REQUIRE(stats.collections == 1);
+    REQUIRE(stats.reclaimed_cells == 2);
+    REQUIRE(stats.reclaimed_bytes >= 2 * sizeof(Cell));
+    REQUIRE(stats.max_pause <= stats.total_pause);
+}
+
+TEST_CASE("Reachable structure survives collection") {
+    CycleCollector collector{0};
+    // A list whose tail loops back to its second cell, held from outside by its head only.
+    auto head = MakeObject<Cell>(Number::Make(1), nullptr);
+    Watch weak_loop;
+    auto loop = MakeObject<Cell>(weak_loop.MakeProbe(), nullptr);
+    loop->SetSecond(MakeObject<Cell>(Number::Make(3), loop));
+    head->SetSecond(loop);
+    loop.reset();
+
+    collector.Collect();
+    REQUIRE(!weak_loop.expired());
+    auto third = As<Cell>(As<Cell>(head->GetSecond())->GetSecond());
+    REQUIRE(Number::GetValue(third->GetFirst()) == 3);
+    REQUIRE(third->GetSecond() == head->GetSecond());
+    REQUIRE(collector.GetStats().reclaimed_cells == 0);
+
+    third.reset();
+    head.reset();
+    collector.Collect();
+    REQUIRE(weak_loop.expired());
+    REQUIRE(collector.GetStats().reclaimed_cells == 2);
+}
+
+TEST_CASE("Collection is triggered by allocation") {
+    CycleCollector collector{100};
+    std::vector<Watch> cycles;
+    for (int i = 0; i < 1000; ++i) {
+        cycles.push_back(MakeGarbageCycle());
+    }
+    REQUIRE(collector.GetStats().collections == 20);
+    REQUIRE(collector.GetTrackedCount() < 100);
+    REQUIRE(cycles.front().expired());
+    // The last cycle was made after the last collection.
+    REQUIRE(!cycles.back().expired());
+    collector.Collect();
+    REQUIRE(cycles.back().expired());
+}
+
+TEST_CASE("Young collections") {
+    CycleCollector collector{0};
+    auto live = MakeObject<Cell>(Number::Make(1), MakeObject<Cell>(Number::Make(2), nullptr));
+    auto cycle = MakeGarbageCycle();
+    collector.CollectYoung();
+    REQUIRE(cycle.expired());
+    REQUIRE(collector.GetOldCount() == 2);
+    REQUIRE(collector.GetStats().young_collections == 1);
+    REQUIRE(collector.GetStats().promoted_cells == 2);
+
+    // A young cell referenced only from an old one survives.
+    Watch young;
+    MakeObject<Cell>(young.MakeProbe(), nullptr);
+    REQUIRE(young.expired());
+    live->SetFirst(MakeObject<Cell>(young.MakeProbe(), nullptr));
+    collector.CollectYoung();
+    REQUIRE(!young.expired());
+    REQUIRE(collector.GetOldCount() == 3);
+
+    // A cycle through both generations is left to a full collection.
+    Watch spanning;
+    auto old = MakeObject<Cell>(spanning.MakeProbe(), nullptr);
+    collector.CollectYoung();
+    old->SetSecond(MakeObject<Cell>(Number::Make(5), old));
+    old.reset();
+    collector.CollectYoung();
+    REQUIRE(!spanning.expired());
+    collector.Collect();
+    REQUIRE(spanning.expired());
+    REQUIRE(collector.GetTrackedCount() == 3);
+    REQUIRE(collector.GetOldCount() == 3);
+    REQUIRE(collector.GetStats().collections == 5);
+}
+
+TEST_CASE("Evaluation with a collector") {
+    const char* kExpressions[] = {"(list 1 (+ 2 3) (cons 4 5) '(6 (7 . 8)))",
+                                  "(list-ref '(1 2 3 4) 2)",
+                                  "(list-tail '(1 2 3) 1)",
+                                  "(and (list? '(1 2)) (pair? '(3 . 4)) (max 1 (abs -5)))"};
+    Interpreter interpreter;
+    std::vector<std::string> expected;
+    for (const char* expression : kExpressions) {
+        expected.push_back(interpreter.Run(expression));
+    }
+
+    // Collecting on every cell stresses that nothing in use is ever taken for garbage.
+    CycleCollector collector{1};
+    for (size_t i = 0; i < std::size(kExpressions); ++i) {
+        REQUIRE(interpreter.Run(kExpressions[i]) == expected[i]);
+    }
+    REQUIRE_THROWS_AS(interpreter.Run("(car (list))"), RuntimeError);
+    REQUIRE(interpreter.RunProgram("(+ 1 2) '(a b . c)") ==
+            std::vector<std::string>{"3", "(a b . c)"});
+    REQUIRE(collector.GetStats().collections > 0);
+    REQUIRE(collector.GetStats().reclaimed_cells == 0);
+}
+
+TEST_CASE("Cells outlive their collector") {
+    Ref<Object> list;
+    {
+        CycleCollector collector;
+        list = MakeObject<Cell>(Number::Make(1), MakeObject<Cell>(Number::Make(2), nullptr));
+    }
+    REQUIRE(CycleCollector::Current() == nullptr);
+    Interpreter interpreter;
+    REQUIRE(interpreter.PerformOutput(list) == "(1 2)");
+}
@@ -0,0 +1,109 @@
+#include <catch.hpp>
+
+#include <collector.h>
+#include <error.h>
+#include <scheme.h>
+
+#include <thread>
+
+static Ref<Object> ReadDatum(std::string_view source) {
+    Tokenizer tokenizer{source};
+    return Read(&tokenizer);
+}
+
+static int ValueAt(Cell* cell) {
+    REQUIRE(cell);
+    return Number::GetValue(cell->GetFirst());
+}
+
+TEST_CASE("Lists are built compact") {
+    std::vector<Ref<Object>> elements;
+    for (int i = 0; i < 5; ++i) {
+        elements.push_back(Number::Make(i * 10));
+    }
+    auto list = MakeCompactList(elements, Number::Make(50));
+    auto& head = AsRef<Cell>(list);
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(ValueAt(head.FindInSegment(i)) == i * 10);
+    }
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(head.FindInSegment(i)->GetSecond().get() == head.FindInSegment(i + 1));
+    }
+    REQUIRE(head.FindInSegment(5) == nullptr);
+    REQUIRE(head.FindInSegment(4)->FindInSegment(1) == nullptr);
+    REQUIRE(Interpreter{}.PerformOutput(list) == "(0 10 20 30 40 . 50)");
+
+    // The cells outlive the head they were built with.
+    auto tail = head.GetSecond();
+    list.reset();
+    REQUIRE(ValueAt(AsRef<Cell>(tail).FindInSegment(3)) == 40);
+}
+
+TEST_CASE("Reader and list make compact lists") {
+    auto datum = ReadDatum("(1 (2 3) '(4 5 6) . 7)");
+    auto& head = AsRef<Cell>(datum);
+    REQUIRE(ValueAt(head.FindInSegment(0)) == 1);
+    auto& nested = AsRef<Cell>(head.FindInSegment(1)->GetFirst());
+    REQUIRE(ValueAt(nested.FindInSegment(1)) == 3);
+    auto& quoted = AsRef<Cell>(head.FindInSegment(2)->GetFirst());
+    REQUIRE(Is<Quote>(quoted.GetFirst()));
+    REQUIRE(ValueAt(AsRef<Cell>(quoted.GetSecond()).FindInSegment(2)) == 6);
+    REQUIRE(Number::GetValue(head.FindInSegment(2)->GetSecond()) == 7);
+
+    auto list = Unpack(ReadDatum("(list 1 2 3 4)"));
+    REQUIRE(ValueAt(AsRef<Cell>(list).FindInSegment(3)) == 4);
+
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(list-ref '(1 2 3 4) 3)") == "4");
+    REQUIRE(interpreter.Run("(list-tail '(1 2 3 4) 2)") == "(3 4)");
+    REQUIRE(interpreter.Run("(list-tail '(1 2 3 4) 4)") == "()");
+    REQUIRE_THROWS_AS(interpreter.Run("(list-ref '(1 2 3 4) 4)"), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(list-tail '(1 2 3 4) 5)"), RuntimeError);
+}
+
+TEST_CASE("Relinked compact lists fall back to walking") {
+    auto list = ReadDatum("(1 2 3 4 5)");
+    auto& head = AsRef<Cell>(list);
+    Cell* second = head.FindInSegment(1);
+    second->SetSecond(ReadDatum("(30 40)"));
+    REQUIRE(head.FindInSegment(1) == second);
+    REQUIRE(head.FindInSegment(2) == nullptr);
+    REQUIRE(ValueAt(AsRef<Cell>(list).FindInSegment(0)) == 1);
+    REQUIRE(Interpreter{}.PerformOutput(list) == "(1 2 30 40)");
+
+    // Setting the same successor again is not a relink.
+    auto other = ReadDatum("(1 2 3)");
+    auto& other_head = AsRef<Cell>(other);
+    other_head.SetSecond(other_head.GetSecond());
+    REQUIRE(ValueAt(other_head.FindInSegment(2)) == 3);
+}
+
+TEST_CASE("Compact lists in arenas and cycles") {
+    Interpreter interpreter{true};
+    REQUIRE(interpreter.Run("(list-ref (list 5 6 7) 2)") == "7");
+    REQUIRE(interpreter.Run("(list-tail '(1 2 3) 1)") == "(2 3)");
+
+    CycleCollector collector{0};
+    std::vector<Ref<Object>> elements(100, Number::Make(1));
+    auto list = MakeCompactList(elements);
+    AsRef<Cell>(list).FindInSegment(99)->SetSecond(list);
+    list.reset();
+    collector.Collect();
+    REQUIRE(collector.GetStats().reclaimed_cells == 100);
+    REQUIRE(collector.GetTrackedCount() == 0);
+}
+
+TEST_CASE("Compact lists shared in part") {
+    // The head stays on this thread while the shared tail dies on another, so the cells of one
+    // segment die on both at once.
+    for (int run = 0; run < 200; ++run) {
+        std::vector<Ref<Object>> elements(1000, Number::Make(run));
+        auto list = MakeCompactList(elements);
+        Ref<Object> tail = AsRef<Cell>(list).FindInSegment(500)->GetSecond();
+        ShareAcrossThreads(tail);
+        REQUIRE_FALSE(list->IsShared());
+        std::jthread other{[tail = std::move(tail)]() mutable { tail.reset(); }};
+        AsRef<Cell>(list).FindInSegment(500)->SetSecond(nullptr);
+        list.reset();
+    }
+}
@@ -0,0 +1,71 @@
+#include <catch.hpp>
+
+#include <cons_heap.h>
+#include <error.h>
+#include <scheme.h>
+
+static const char* kDatums[] = {"(1 2 3)",
+                                "()",
+                                "42",
+                                "-7",
+                                "#t",
+                                "foo",
+                                "(1 . 2)",
+                                "(1 2 . 3)",
+                                "((1 2) (3 (4 5)) () #f)",
+                                "(a 'b '(c d))",
+                                "(536870911 536870912 -536870912 -536870913 2147483647)"};
+
+TEST_CASE("Cons heap matches cells") {
+    Interpreter interpreter;
+    for (const char* datum : kDatums) {
+        INFO(datum);
+        Tokenizer cell_tokenizer{std::string_view{datum}};
+        auto cells = Read(&cell_tokenizer);
+        std::string expected = interpreter.PerformOutput(cells);
+
+        ConsHeap heap;
+        Tokenizer tokenizer{std::string_view{datum}};
+        auto read = heap.Read(&tokenizer);
+        REQUIRE(tokenizer.IsEnd());
+        REQUIRE(heap.ToString(read) == expected);
+        auto imported = heap.Import(cells);
+        REQUIRE(heap.ToString(imported) == expected);
+        REQUIRE(interpreter.PerformOutput(heap.Export(read)) == expected);
+    }
+}
+
+TEST_CASE("Cons heap values") {
+    ConsHeap heap;
+    REQUIRE(heap.GetPairCount() == 0);
+    REQUIRE(!ConsHeap::IsPair(ConsHeap::kNil));
+    auto pair = heap.Cons(heap.MakeNumber(1), ConsHeap::kNil);
+    REQUIRE(ConsHeap::IsPair(pair));
+    REQUIRE(heap.Car(pair) == heap.MakeNumber(1));
+    heap.SetCdr(pair, heap.MakeNumber(ConsHeap::kMaxFixnum + 1));
+    REQUIRE(heap.ToString(pair) == "(1 . 536870912)");
+    heap.SetCar(pair, heap.MakeAtom(SymbolTable::Instantiate().Intern("x")));
+    REQUIRE(heap.ToString(pair) == "(x . 536870912)");
+    REQUIRE(heap.MakeAtom(Boolean::Make(true)) == heap.MakeAtom(Boolean::Make(true)));
+    REQUIRE(heap.GetPairCount() == 1);
+}
+
+TEST_CASE("Cons heap list operations") {
+    ConsHeap heap;
+    Tokenizer tokenizer{std::string_view{"(10 (20 21) 30 . 40)"}};
+    auto list = heap.Read(&tokenizer);
+    REQUIRE(heap.ToString(heap.ListRef(list, 0)) == "10");
+    REQUIRE(heap.ToString(heap.ListRef(list, 1)) == "(20 21)");
+    REQUIRE(heap.ToString(heap.ListTail(list, 2)) == "(30 . 40)");
+    REQUIRE(heap.ListTail(list, 3) == heap.MakeNumber(40));
+    REQUIRE_THROWS_AS(heap.ListRef(list, 3), RuntimeError);
+    REQUIRE_THROWS_AS(heap.ListTail(list, 4), RuntimeError);
+    REQUIRE(!heap.IsList(list));
+    REQUIRE(heap.IsList(heap.ListRef(list, 1)));
+    REQUIRE(heap.IsList(ConsHeap::kNil));
+    REQUIRE(heap.GetPairCount() == 5);
+    REQUIRE(heap.GetMemoryUsage() >= 6 * 2 * sizeof(ConsHeap::Value));
+
+    Tokenizer bad{std::string_view{"(1 . 2 3)"}};
+    REQUIRE_THROWS_AS(heap.Read(&bad), SyntaxError);
+}
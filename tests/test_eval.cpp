@@ -1,5 +1,10 @@
 #include "scheme_test.h"
 
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
 TEST_CASE_METHOD(SchemeTest, "Quote") {
     ExpectEq("(quote (1 2))", "(1 2)");
     ExpectEq("'(1 2)", "(1 2)");
@@ -11,3 +16,129 @@ TEST_CASE_METHOD(SchemeTest, "Be careful") {
     ExpectRuntimeError("('() ())");
     ExpectEq("'(())", "(())");
 }
+
+TEST_CASE("Immediate numbers and booleans") {
+    for (int value : {0, 1, -1, 1023, 1 << 30, std::numeric_limits<int>::min(),
+                      std::numeric_limits<int>::max()}) {
+        auto number = Number::Make(value);
+        REQUIRE(Number::GetValue(number) == value);
+        REQUIRE(number == Number::Make(value));
+        REQUIRE(Is<Number>(number));
+        REQUIRE(!Is<Boolean>(number));
+        REQUIRE(!Is<Cell>(number));
+        REQUIRE(!Is<Symbol>(number));
+    }
+    REQUIRE(Number::Make(7) != Number::Make(8));
+    REQUIRE(Boolean::Make(true) == Boolean::Make(true));
+    REQUIRE(Boolean::Make(true) != Boolean::Make(false));
+    REQUIRE(Boolean::GetValue(Boolean::Make(true)));
+    REQUIRE(!Boolean::GetValue(Boolean::Make(false)));
+    REQUIRE(Is<Boolean>(Boolean::Make(false)));
+    REQUIRE(!Is<Number>(Boolean::Make(false)));
+    REQUIRE(!Is<Quote>(Boolean::Make(true)));
+
+    // Evaluating arithmetic and logic creates no objects, however large the numbers.
+    Tokenizer arithmetic{std::string_view{
+        "(+ 1 (* 2000 3000) (- 10 400000) (max 4 (abs -5000000)) (min 7 8))"}};
+    auto sum = Read(&arithmetic);
+    Tokenizer logic{std::string_view{"(and (< 1 200000) (or #f (= 3 3)) (number? 4))"}};
+    auto conjunction = Read(&logic);
+    size_t allocations = 0;
+    RunArena arena{&allocations};
+    REQUIRE(Number::GetValue(Unpack(sum)) == 1 + 6000000 + 10 - 400000 + 5000000 + 7);
+    REQUIRE(Boolean::GetValue(Unpack(conjunction)));
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Run a mapped file") {
+    auto path = std::filesystem::temp_directory_path() / "scheme_run_file_test.scm";
+    Interpreter interpreter;
+    {
+        std::ofstream out{path};
+        out << "(+ 1\n   (* 2 3))\n";
+    }
+    REQUIRE(interpreter.RunFile(path.string()) == "7");
+    {
+        std::ofstream out{path, std::ios::trunc};
+    }
+    REQUIRE_THROWS_AS(interpreter.RunFile(path.string()), SyntaxError);
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(interpreter.RunFile(path.string()), std::system_error);
+}
+
+TEST_CASE("Run arena") {
+    Interpreter interpreter{true};
+    REQUIRE(interpreter.Run("(+ 1 (* 2 3) (max 4 5))") == "12");
+    size_t allocations = interpreter.GetArenaAllocationCount();
+    REQUIRE(allocations > 0);
+    REQUIRE(interpreter.Run("'(1 (2 . #t) x)") == "(1 (2 . #t) x)");
+    REQUIRE_THROWS_AS(interpreter.Run("(+ 1 #t)"), RuntimeError);
+    REQUIRE(interpreter.GetArenaAllocationCount() > allocations);
+    REQUIRE(RunArena::Current() == nullptr);
+
+    Interpreter heap_interpreter;
+    REQUIRE(heap_interpreter.Run("'(1 (2 . #t) x)") == "(1 (2 . #t) x)");
+    REQUIRE(heap_interpreter.GetArenaAllocationCount() == 0);
+}
+
+TEST_CASE("Builtins outlive the arena of the run that first uses them") {
+    Interpreter interpreter{true};
+    REQUIRE(interpreter.Run("'(1 2)") == "(1 2)");
+    REQUIRE(interpreter.Run("(quote (1 2))") == "(1 2)");
+
+    size_t allocations = 0;
+    RunArena arena{&allocations};
+    for (std::string_view name : {"quote", "list", "list-ref", "+", "cons"}) {
+        size_t id = SymbolTable::Instantiate().Intern(name)->GetId();
+        auto builtin = OperationsMap::Instantiate().GetOperation(id);
+        REQUIRE(builtin);
+        REQUIRE(builtin->GetOrigin() != RefCounted::Origin::ARENA);
+        REQUIRE(builtin->IsShared());
+    }
+}
+
+TEST_CASE("Run a program") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.RunProgram("").empty());
+    REQUIRE(interpreter.RunProgram("(+ 1 2) '(a . b)\n#t (max 3 4)") ==
+            std::vector<std::string>{"3", "(a . b)", "#t", "4"});
+
+    std::string program;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 1000; ++i) {
+        program += "(* " + std::to_string(i) + " 2)\n";
+        expected.push_back(std::to_string(i * 2));
+    }
+    REQUIRE(interpreter.RunProgram(program) == expected);
+
+    REQUIRE_THROWS_AS(interpreter.RunProgram("(+ 1 2) (+ 1"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.RunProgram("(+ 1 #t) " + program), RuntimeError);
+}
+
+TEST_CASE("Run a lazily read file") {
+    auto path = std::filesystem::temp_directory_path() / "scheme_run_lazy_file_test.scm";
+    {
+        std::ofstream out{path};
+        out << "(+ 1 (* 2 3))\n'(a (b . c))\n(and #f (+ 1 (2 . . 3)))\n(or #t (1 . . 2))\n";
+    }
+    Interpreter interpreter{true};
+    REQUIRE(interpreter.RunLazyFile(path.string()) ==
+            std::vector<std::string>{"7", "(a (b . c))", "#f", "#t"});
+    {
+        std::ofstream out{path, std::ios::trunc};
+        out << "(+ 1 2) (and #t (1 . . 2))";
+    }
+    REQUIRE_THROWS_AS(interpreter.RunLazyFile(path.string()), SyntaxError);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Run canonical") {
+    using namespace std::string_literals;
+    Interpreter interpreter;
+    REQUIRE(interpreter.RunCanonical("(1:+i\x02\0\0\0(1:*i\x03\0\0\0i\xff\xff\xff\xff))"s) ==
+            "i\xff\xff\xff\xff"s);
+    REQUIRE(interpreter.RunCanonical("'(1:a(t.f))"s) == "(1:a(t.f))");
+    REQUIRE(interpreter.RunCanonical("(4:list)") == "()");
+    REQUIRE_THROWS_AS(interpreter.RunCanonical("(1:+"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.RunCanonical("(1:+t)"), RuntimeError);
+}
@@ -0,0 +1,155 @@
+#include <catch.hpp>
+
+#include <fasl.h>
+#include <parser.h>
+#include <scheme.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+static std::filesystem::path MakeCacheDir() {
+    auto dir = std::filesystem::temp_directory_path() / "scheme_fasl_test";
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+static size_t CountFiles(const std::filesystem::path& dir) {
+    size_t count = 0;
+    for ([[maybe_unused]] auto& entry : std::filesystem::directory_iterator{dir}) {
+        ++count;
+    }
+    return count;
+}
+
+TEST_CASE("Fasl round trip") {
+    auto dir = MakeCacheDir();
+    std::string source = "(+ 1 2) '(a . #f) () foo -17 '(1 (2 (3 'x)) . 4) (quote ())";
+    Interpreter interpreter;
+    std::vector<std::string> expected;
+    Tokenizer tokenizer{std::string_view{source}};
+    while (!tokenizer.IsEnd()) {
+        expected.push_back(interpreter.PerformOutput(ReadNext(&tokenizer)));
+    }
+
+    auto cold = ReadCached(source, dir.string());
+    REQUIRE(CountFiles(dir) == 1);
+    auto warm = ReadCached(source, dir.string());
+    REQUIRE(warm.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(interpreter.PerformOutput(cold[i]) == expected[i]);
+        REQUIRE(interpreter.PerformOutput(warm[i]) == expected[i]);
+    }
+    REQUIRE(As<Cell>(warm[0])->GetFirst() == SymbolTable::Instantiate().Intern("+"));
+
+    ReadCached(source + " bar", dir.string());
+    REQUIRE(CountFiles(dir) == 2);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Fasl keeps sharing and rejects stale or broken files") {
+    auto dir = MakeCacheDir();
+    std::filesystem::create_directories(dir);
+    auto path = (dir / "shared.fasl").string();
+    auto shared = MakeObject<Cell>(Number::Make(1), nullptr);
+    auto datum = MakeObject<Cell>(shared, shared);
+    WriteFasl(path, 42, {datum, shared});
+
+    auto loaded = LoadFasl(path, 42);
+    REQUIRE(loaded);
+    REQUIRE(loaded->size() == 2);
+    auto cell = As<Cell>((*loaded)[0]);
+    REQUIRE(cell->GetFirst() == cell->GetSecond());
+    REQUIRE(cell->GetFirst() == (*loaded)[1]);
+
+    REQUIRE(!LoadFasl(path, 43));
+    REQUIRE(!LoadFasl((dir / "missing.fasl").string(), 42));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    REQUIRE(!LoadFasl(path, 42));
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Concurrent fasl writers publish whole files") {
+    auto dir = MakeCacheDir();
+    std::filesystem::create_directories(dir);
+    auto path = (dir / "concurrent.fasl").string();
+    std::vector<Ref<Object>> elements;
+    for (int i = 0; i < 10'000; ++i) {
+        elements.push_back(Number::Make(i));
+    }
+    auto datum = MakeCompactList(elements);
+    ShareAcrossThreads(datum);
+    {
+        std::vector<std::jthread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&] {
+                for (int i = 0; i < 10; ++i) {
+                    WriteFasl(path, 42, {datum});
+                }
+            });
+        }
+    }
+    auto loaded = LoadFasl(path, 42);
+    REQUIRE(loaded);
+    REQUIRE(GetListLength(loaded->front()) == 10'000);
+    REQUIRE(CountFiles(dir) == 1);
+    std::filesystem::remove_all(dir);
+}
+
+static uint32_t ReadWord(const std::string& path, size_t offset) {
+    std::ifstream in{path, std::ios::binary};
+    in.seekg(offset);
+    uint32_t word = 0;
+    in.read(reinterpret_cast<char*>(&word), sizeof(word));
+    return word;
+}
+
+static void WriteWord(const std::string& path, size_t offset, uint32_t word) {
+    std::fstream out{path, std::ios::binary | std::ios::in | std::ios::out};
+    out.seekp(offset);
+    out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+TEST_CASE("Fasl rejects references to records already moved out") {
+    auto dir = MakeCacheDir();
+    std::filesystem::create_directories(dir);
+    auto path = (dir / "moved.fasl").string();
+    // Records: 1 the number, 2 the shared cell, 3 the datum (2 . 2); roots 3 and 2. There are
+    // no symbols, so the 32-byte header is followed by the 12-byte records, then the roots.
+    auto shared = MakeObject<Cell>(Number::Make(1), nullptr);
+    WriteFasl(path, 42, {MakeObject<Cell>(shared, shared), shared});
+    REQUIRE(LoadFasl(path, 42));
+    constexpr size_t kDatumFirst = 32 + 3 * 12 + 4;
+    constexpr size_t kRoots = 32 + 4 * 12;
+    constexpr uint32_t kLastUse = 1u << 31;
+    uint32_t datum_first = ReadWord(path, kDatumFirst);
+    uint32_t first_root = ReadWord(path, kRoots);
+    REQUIRE(datum_first == 2);
+    REQUIRE(first_root == (3 | kLastUse));
+
+    // The car of the datum moves the shared cell out before its cdr reads it.
+    WriteWord(path, kDatumFirst, datum_first | kLastUse);
+    REQUIRE(!LoadFasl(path, 42));
+    WriteWord(path, kDatumFirst, datum_first);
+    REQUIRE(LoadFasl(path, 42));
+
+    // Both roots take the datum.
+    WriteWord(path, kRoots + 4, first_root);
+    REQUIRE(!LoadFasl(path, 42));
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Run a cached file") {
+    auto dir = MakeCacheDir();
+    auto path = std::filesystem::temp_directory_path() / "scheme_fasl_test.scm";
+    {
+        std::ofstream out{path};
+        out << "(+ 1 2)\n(car '(5 6))\n'(a b)\n";
+    }
+    Interpreter interpreter;
+    std::vector<std::string> expected{"3", "5", "(a b)"};
+    REQUIRE(interpreter.RunCachedFile(path.string(), dir.string()) == expected);
+    REQUIRE(interpreter.RunCachedFile(path.string(), dir.string()) == expected);
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(dir);
+}
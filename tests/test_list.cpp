@@ -19,6 +19,14 @@ TEST_CASE_METHOD(SchemeTest, "ListSyntax") {
     ExpectEq("'(1 . (2 . ()))", "(1 2)");
 }
 
+TEST_CASE_METHOD(SchemeTest, "LongList") {
+    std::string list;
+    for (int i = 0; i < 200'000; ++i) {
+        list += (i ? " " : "") + std::to_string(i % 7);
+    }
+    ExpectEq("'(" + list + ")", "(" + list + ")");
+}
+
 TEST_CASE_METHOD(SchemeTest, "ListInvalidSyntax") {
     ExpectSyntaxError("((1)");
     ExpectSyntaxError(")(1)");
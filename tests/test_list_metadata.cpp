@@ -0,0 +1,151 @@
+#include <catch.hpp>
+
+#include <error.h>
+#include <scheme.h>
+
+// A list of `size` separately allocated cells holding 0, 1, ..., as `cons` would build it.
+static Ref<Object> MakeLinkedList(int size, Ref<Object> tail = nullptr) {
+    Ref<Object> list = std::move(tail);
+    for (int i = size; i-- > 0;) {
+        list = MakeObject<Cell>(Number::Make(i), std::move(list));
+    }
+    return list;
+}
+
+static int ListRefValue(const Ref<Object>& list, int index) {
+    const Ref<Object>* at = AdvanceList(list, index).object;
+    REQUIRE(Is<Cell>(*at));
+    return Number::GetValue(AsRef<Cell>(*at).GetFirst());
+}
+
+TEST_CASE("Length") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(length '())") == "0");
+    REQUIRE(interpreter.Run("(length '(1 2 3))") == "3");
+    REQUIRE(interpreter.Run("(length '((1 2) 3))") == "2");
+    REQUIRE(interpreter.Run("(length (list 1 2 3 4))") == "4");
+    REQUIRE_THROWS_AS(interpreter.Run("(length '(1 2 . 3))"), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(length 1)"), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(length '(1) '(2))"), RuntimeError);
+
+    REQUIRE(interpreter.Run("(list? '((1) . 2))") == "#f");
+    REQUIRE(interpreter.Run("(list? '((1) (2)))") == "#t");
+}
+
+TEST_CASE("Lengths of mixed lists") {
+    std::vector<Ref<Object>> elements(1000, Number::Make(1));
+    auto list = MakeLinkedList(3, MakeCompactList(elements));
+    REQUIRE(GetListLength(list) == 1003);
+    REQUIRE(GetListLength(list) == 1003);
+    REQUIRE(ListRefValue(list, 2) == 2);
+    REQUIRE(GetListLength(AsRef<Cell>(list).GetSecond()) == 1002);
+
+    // Relinking inside the segment changes the length of every list sharing it.
+    auto& segment = AsRef<Cell>(*AdvanceList(list, 3).object);
+    segment.FindInSegment(499)->SetSecond(Number::Make(7));
+    REQUIRE(GetListLength(list) == std::nullopt);
+    REQUIRE(AdvanceList(list, SIZE_MAX).index == 503);
+    segment.FindInSegment(499)->SetSecond(nullptr);
+    REQUIRE(GetListLength(list) == 503);
+}
+
+TEST_CASE("Circular lists are not lists") {
+    auto linked = MakeLinkedList(100);
+    auto& last = AsRef<Cell>(*AdvanceList(linked, 99).object);
+    last.SetSecond(*AdvanceList(linked, 40).object);
+    REQUIRE(GetListLength(linked) == std::nullopt);
+    REQUIRE(AdvanceList(linked, SIZE_MAX).is_circular);
+    REQUIRE(ListRefValue(linked, 1000) == 40 + (1000 - 40) % 60);
+    REQUIRE_FALSE(ListFunc{}(linked));
+    last.SetSecond(nullptr);
+
+    std::vector<Ref<Object>> elements(100, Number::Make(1));
+    auto compact = MakeCompactList(elements);
+    AsRef<Cell>(compact).FindInSegment(99)->SetSecond(compact);
+    REQUIRE(GetListLength(compact) == std::nullopt);
+    REQUIRE(AdvanceList(compact, 12345).index == 12345);
+    AsRef<Cell>(compact).FindInSegment(99)->SetSecond(nullptr);
+    REQUIRE(GetListLength(compact) == 100);
+}
+
+TEST_CASE("List walks resume where the last one stopped") {
+    auto list = MakeLinkedList(10'000);
+    for (int i = 0; i < 10'000; ++i) {
+        REQUIRE(ListRefValue(list, i) == i);
+    }
+    REQUIRE(GetListLength(list) == 10'000);
+    REQUIRE(ListRefValue(list, 5) == 5);
+
+    // Relinking a cell the walks have passed invalidates the cursor.
+    AsRef<Cell>(*AdvanceList(list, 20).object).SetSecond(MakeLinkedList(3));
+    REQUIRE(GetListLength(list) == 24);
+    REQUIRE(ListRefValue(list, 22) == 1);
+
+    // A new list in the cells of a freed one does not pick up its cursor.
+    list = MakeLinkedList(50);
+    REQUIRE(GetListLength(list) == 50);
+    list.reset();
+    list = MakeLinkedList(10);
+    REQUIRE(GetListLength(list) == 10);
+    REQUIRE(AdvanceList(list, 30).index == 10);
+}
+
+TEST_CASE("Lists walked in turn keep their cursors") {
+    std::vector<Ref<Object>> lists;
+    for (int i = 0; i < 20; ++i) {
+        lists.push_back(MakeLinkedList(500));
+    }
+    for (int i = 0; i < 500; ++i) {
+        for (const auto& list : lists) {
+            REQUIRE(ListRefValue(list, i) == i);
+        }
+    }
+    for (const auto& list : lists) {
+        REQUIRE(GetListLength(list) == 500);
+    }
+}
+
+TEST_CASE("Lists headed in a segment get cursors") {
+    std::vector<Ref<Object>> elements;
+    for (int i = 0; i < 1000; ++i) {
+        elements.push_back(Number::Make(i));
+    }
+    auto list = MakeCompactList(elements);
+    auto& head = AsRef<Cell>(list);
+    head.FindInSegment(499)->SetSecond(MakeLinkedList(600, head.FindInSegment(500)->GetSecond()));
+    REQUIRE(GetListLength(list) == 1599);
+    REQUIRE(GetListLength(list) == 1599);
+    for (int i = 0; i < 1599; ++i) {
+        REQUIRE(ListRefValue(list, i) == (i < 500 ? i : i < 1100 ? i - 500 : i - 599));
+    }
+
+    // Heads in the same segment share its stamp, but not their cursors.
+    const auto& middle = head.FindInSegment(100)->GetSecond();
+    REQUIRE(GetListLength(middle) == 1498);
+    REQUIRE(ListRefValue(middle, 0) == 101);
+    REQUIRE(GetListLength(list) == 1599);
+
+    // A new segment in the block of a freed one does not pick up its cursors.
+    list.reset();
+    elements.clear();
+    for (int i = 0; i < 10; ++i) {
+        elements.push_back(Number::Make(i));
+    }
+    list = MakeCompactList(elements);
+    REQUIRE(GetListLength(list) == 10);
+    REQUIRE(AdvanceList(list, 30).index == 10);
+}
+
+TEST_CASE("Relinking cells no walk has passed keeps the cursors") {
+    auto list = MakeLinkedList(200);
+    REQUIRE(ListRefValue(list, 100) == 100);
+
+    // Past the cursor, and in a list being built: the walks still see the new links.
+    AsRef<Cell>(*AdvanceList(list, 150).object).SetSecond(MakeLinkedList(5));
+    REQUIRE(GetListLength(list) == 156);
+    auto other = MakeLinkedList(3);
+    AsRef<Cell>(other).SetSecond(nullptr);
+    REQUIRE(GetListLength(other) == 1);
+    REQUIRE(ListRefValue(list, 152) == 1);
+    REQUIRE(GetListLength(list) == 156);
+}
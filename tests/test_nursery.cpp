@@ -0,0 +1,175 @@
+#include <catch.hpp>
+
+#include <collector.h>
+#include <error.h>
+#include <nursery.h>
+#include <scheme.h>
+
+#include <thread>
+
+// (0 1 ... size-1), built a cell at a time as cons does.
+static Ref<Object> ConsList(int size) {
+    Ref<Object> list;
+    for (int i = size; i-- > 0;) {
+        list = MakeObject<Cell>(Number::Make(i), std::move(list));
+    }
+    return list;
+}
+
+static void RequireCountingList(const Ref<Object>& list, int size) {
+    REQUIRE(GetListLength(list) == static_cast<size_t>(size));
+    int i = 0;
+    for (Cell* cell = TryAs<Cell>(list.get()); cell; cell = TryAs<Cell>(cell->GetSecond().get())) {
+        REQUIRE(Number::GetValue(cell->GetFirst()) == i++);
+    }
+}
+
+TEST_CASE("Young lists are promoted into one segment") {
+    Nursery nursery;
+    REQUIRE(Nursery::Current() == &nursery);
+    const Object* first_slot = MakeObject<Cell>(nullptr, nullptr).get();
+    auto holder = MakeHeapObject<Cell>(nullptr, nullptr);
+    auto list = ConsList(100);
+    REQUIRE(nursery.IsYoung(list.get()));
+    REQUIRE(!nursery.IsYoung(holder.get()));
+    holder->SetSecond(std::move(list));
+    REQUIRE(nursery.GetYoungCount() == 100);
+
+    nursery.Collect();
+    REQUIRE(nursery.GetYoungCount() == 0);
+    const auto& stats = nursery.GetStats();
+    REQUIRE(stats.collections == 1);
+    REQUIRE(stats.promoted_cells == 100);
+    REQUIRE(stats.promoted_runs == 1);
+    REQUIRE(stats.pinned_cells == 0);
+    const auto& promoted = holder->GetSecond();
+    REQUIRE(!nursery.IsYoung(promoted.get()));
+    REQUIRE(AsRef<Cell>(promoted).GetSegmentReach() == 99);
+    RequireCountingList(promoted, 100);
+
+    // New cells reuse the emptied chunk.
+    auto cell = MakeObject<Cell>(nullptr, nullptr);
+    REQUIRE(cell.get() == first_slot);
+}
+
+TEST_CASE("Young cells referenced from outside stay in place") {
+    Nursery nursery;
+    auto list = ConsList(10);
+    Object* head = list.get();
+    // The cursor of this walk lies in the cells that move.
+    RequireCountingList(list, 10);
+
+    nursery.Collect();
+    REQUIRE(list.get() == head);
+    REQUIRE(list->GetOrigin() == RefCounted::Origin::NURSERY);
+    // Its chunk has left the nursery, so it is old now.
+    REQUIRE(!nursery.IsYoung(head));
+    const auto& stats = nursery.GetStats();
+    REQUIRE(stats.pinned_cells == 1);
+    REQUIRE(stats.promoted_cells == 9);
+    REQUIRE(AsRef<Cell>(AsRef<Cell>(list).GetSecond()).GetSegmentReach() == 8);
+    RequireCountingList(list, 10);
+
+    auto young = ConsList(10);
+    AsRef<Cell>(list).SetFirst(young);
+    young.reset();
+    nursery.Collect();
+    REQUIRE(nursery.GetYoungCount() == 0);
+    RequireCountingList(AsRef<Cell>(list).GetFirst(), 10);
+}
+
+TEST_CASE("Old cells stored into are forwarded") {
+    Nursery nursery;
+    std::vector<Ref<Object>> elements{ConsList(3), ConsList(4)};
+    auto compact = MakeCompactList(elements);
+    auto holder = MakeHeapObject<Cell>(nullptr, nullptr);
+    holder->SetFirst(ConsList(5));
+    holder->SetFirst(ConsList(6));
+    REQUIRE(nursery.GetYoungCount() == 3 + 4 + 6);
+
+    nursery.Collect();
+    REQUIRE(nursery.GetYoungCount() == 0);
+    const auto& stats = nursery.GetStats();
+    REQUIRE(stats.promoted_cells == 3 + 4 + 6);
+    REQUIRE(stats.promoted_runs == 3);
+    REQUIRE(stats.pinned_cells == 0);
+    RequireCountingList(AsRef<Cell>(compact).GetFirst(), 3);
+    RequireCountingList(AsRef<Cell>(AsRef<Cell>(compact).GetSecond()).GetFirst(), 4);
+    RequireCountingList(holder->GetFirst(), 6);
+}
+
+TEST_CASE("Young garbage cycles are freed") {
+    Nursery nursery;
+    auto marker = MakeObject<Quote>();
+    {
+        auto first = MakeObject<Cell>(marker, nullptr);
+        first->SetSecond(MakeObject<Cell>(Number::Make(2), first));
+    }
+    REQUIRE(nursery.GetYoungCount() == 2);
+    REQUIRE(marker.use_count() == 2);
+
+    nursery.Collect();
+    REQUIRE(nursery.GetYoungCount() == 0);
+    REQUIRE(marker.use_count() == 1);
+    const auto& stats = nursery.GetStats();
+    REQUIRE(stats.reclaimed_cells == 2);
+    REQUIRE(stats.promoted_cells == 0);
+
+    // A cycle reachable from outside survives as one.
+    auto cycle = MakeObject<Cell>(Number::Make(1), nullptr);
+    cycle->SetSecond(MakeObject<Cell>(Number::Make(2), cycle));
+    nursery.Collect();
+    REQUIRE(AsRef<Cell>(AsRef<Cell>(cycle->GetSecond()).GetSecond()).GetFirst().get() ==
+            Number::Make(1).get());
+    REQUIRE(AsRef<Cell>(cycle->GetSecond()).GetSecond() == cycle);
+    REQUIRE(!GetListLength(cycle));
+    cycle->SetSecond(nullptr);
+}
+
+TEST_CASE("Nurseries with arenas, collectors and other threads") {
+    Nursery nursery;
+    {
+        RunArena arena{nullptr};
+        REQUIRE(MakeObject<Cell>(nullptr, nullptr)->GetOrigin() == RefCounted::Origin::ARENA);
+    }
+    REQUIRE(nursery.IsYoung(MakeObject<Cell>(nullptr, nullptr).get()));
+
+    CycleCollector collector{0};
+    auto list = ConsList(20);
+    auto holder = MakeHeapObject<Cell>(nullptr, nullptr);
+    holder->SetSecond(list);
+    list.reset();
+    REQUIRE(collector.GetTrackedCount() == 21);
+    nursery.Collect();
+    REQUIRE(collector.GetTrackedCount() == 21);
+    collector.Collect();
+    RequireCountingList(holder->GetSecond(), 20);
+
+    auto shared = ConsList(3);
+    ShareAcrossThreads(shared);
+    REQUIRE(!nursery.IsYoung(shared.get()));
+    std::thread([shared = std::move(shared)] {}).join();
+
+    // Overflowing the nursery leaves the oldest cells where they are.
+    Nursery small{1};
+    std::vector<Ref<Object>> cells;
+    for (int i = 0; i < 5000; ++i) {
+        cells.push_back(MakeObject<Cell>(Number::Make(i), nullptr));
+    }
+    REQUIRE(small.GetYoungCount() < cells.size());
+    small.Collect();
+    REQUIRE(small.GetYoungCount() == 0);
+    for (int i = 0; i < 5000; ++i) {
+        REQUIRE(Number::GetValue(AsRef<Cell>(cells[i]).GetFirst()) == i);
+    }
+}
+
+TEST_CASE("Runs between nursery collections") {
+    Nursery nursery;
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(cons 1 2)") == "(1 . 2)");
+    REQUIRE(interpreter.Run("(list-ref '(1 2 3) 1)") == "2");
+    nursery.Collect();
+    REQUIRE(nursery.GetYoungCount() == 0);
+    REQUIRE(nursery.GetStats().pinned_cells == 0);
+}
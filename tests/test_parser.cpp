@@ -4,6 +4,7 @@
 
 #include <error.h>
 #include <parser.h>
+#include <scheme.h>
 
 auto ReadFull(const std::string& str) {
     std::stringstream ss{str};
@@ -17,11 +18,11 @@ auto ReadFull(const std::string& str) {
 TEST_CASE("Read number") {
     auto node = ReadFull("5");
     REQUIRE(Is<Number>(node));
-    REQUIRE(As<Number>(node)->GetValue() == 5);
+    REQUIRE(Number::GetValue(node) == 5);
 
     node = ReadFull("-5");
     REQUIRE(Is<Number>(node));
-    REQUIRE(As<Number>(node)->GetValue() == -5);
+    REQUIRE(Number::GetValue(node) == -5);
 }
 
 std::string RandomSymbol(std::default_random_engine* rng) {
@@ -51,6 +52,18 @@ TEST_CASE("Read symbol") {
     }
 }
 
+TEST_CASE("Symbols are interned") {
+    auto list = ReadFull("(foo bar foo)");
+    auto first = As<Cell>(list)->GetFirst();
+    auto second = As<Cell>(As<Cell>(list)->GetSecond())->GetFirst();
+    auto third = As<Cell>(As<Cell>(As<Cell>(list)->GetSecond())->GetSecond())->GetFirst();
+    REQUIRE(first == third);
+    REQUIRE(first != second);
+    REQUIRE(As<Symbol>(first)->GetId() != As<Symbol>(second)->GetId());
+    REQUIRE(ReadFull("foo") == first);
+    REQUIRE(SymbolTable::Instantiate().Intern("foo") == first);
+}
+
 TEST_CASE("Lists") {
     SECTION("Empty list") {
         auto null = ReadFull("()");
@@ -63,11 +76,11 @@ TEST_CASE("Lists") {
 
         auto first = As<Cell>(pair)->GetFirst();
         REQUIRE(Is<Number>(first));
-        REQUIRE(As<Number>(first)->GetValue() == 1);
+        REQUIRE(Number::GetValue(first) == 1);
 
         auto second = As<Cell>(pair)->GetSecond();
         REQUIRE(Is<Number>(second));
-        REQUIRE(As<Number>(second)->GetValue() == 2);
+        REQUIRE(Number::GetValue(second) == 2);
     }
 
     SECTION("Simple list") {
@@ -76,12 +89,12 @@ TEST_CASE("Lists") {
 
         auto first = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(first));
-        REQUIRE(As<Number>(first)->GetValue() == 1);
+        REQUIRE(Number::GetValue(first) == 1);
 
         list = As<Cell>(list)->GetSecond();
         auto second = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(second));
-        REQUIRE(As<Number>(second)->GetValue() == 2);
+        REQUIRE(Number::GetValue(second) == 2);
 
         REQUIRE(!As<Cell>(list)->GetSecond());
     }
@@ -97,12 +110,12 @@ TEST_CASE("Lists") {
         list = As<Cell>(list)->GetSecond();
         auto second = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(second));
-        REQUIRE(As<Number>(second)->GetValue() == 1);
+        REQUIRE(Number::GetValue(second) == 1);
 
         list = As<Cell>(list)->GetSecond();
         second = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(second));
-        REQUIRE(As<Number>(second)->GetValue() == 2);
+        REQUIRE(Number::GetValue(second) == 2);
 
         REQUIRE(!As<Cell>(list)->GetSecond());
     }
@@ -114,16 +127,16 @@ TEST_CASE("Lists") {
 
         auto first = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(first));
-        REQUIRE(As<Number>(first)->GetValue() == 1);
+        REQUIRE(Number::GetValue(first) == 1);
 
         list = As<Cell>(list)->GetSecond();
         auto second = As<Cell>(list)->GetFirst();
         REQUIRE(Is<Number>(second));
-        REQUIRE(As<Number>(second)->GetValue() == 2);
+        REQUIRE(Number::GetValue(second) == 2);
 
         auto last = As<Cell>(list)->GetSecond();
         REQUIRE(Is<Number>(last));
-        REQUIRE(As<Number>(last)->GetValue() == 3);
+        REQUIRE(Number::GetValue(last) == 3);
     }
 
     SECTION("Complex lists") {
@@ -154,3 +167,313 @@ TEST_CASE("Invalid") {
     REQUIRE_THROWS_AS(ReadFull("(1 . )"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . 2 3)"), SyntaxError);
 }
+
+TEST_CASE("Token buffer reader matches tokenizer reader") {
+    const char* kInputs[] = {"5", "-5", "foo", "#t", "'x", "()", "(())", "(1 . 2)", "(1 2 . 3)",
+                             "(1 . (2 . ()))", "(+ 1 2 (- 3 4))", "'(a 'b (c . d))", "')",
+                             "", "'", "(", "((1)", "(1 .", "( .", "(1 . )", "(1 . 2 3)",
+                             "(1 2))", ")(1)", "(.)", "(. 2)"};
+    Interpreter interpreter;
+    for (std::string_view input : kInputs) {
+        Ref<Object> expected;
+        bool expected_error = false;
+        try {
+            Tokenizer tokenizer{input};
+            expected = Read(&tokenizer);
+        } catch (const SyntaxError&) {
+            expected_error = true;
+        }
+        if (expected_error) {
+            REQUIRE_THROWS_AS(Read(Tokenizer::TokenizeAll(input)), SyntaxError);
+        } else {
+            auto tokens = Tokenizer::TokenizeAll(input);
+            REQUIRE(interpreter.PerformOutput(Read(tokens)) == interpreter.PerformOutput(expected));
+        }
+    }
+}
+
+TEST_CASE("Long and deep lists") {
+    constexpr size_t kLength = 1'000'000;
+    std::string input = "'(";
+    for (size_t i = 0; i < kLength; ++i) {
+        input += std::to_string(i % 10) + ' ';
+    }
+    input += ')';
+    auto list = As<Cell>(ReadFull(input))->GetSecond();
+    size_t length = 0;
+    for (; Is<Cell>(list); list = As<Cell>(list)->GetSecond()) {
+        ++length;
+    }
+    REQUIRE(length == kLength);
+
+    constexpr size_t kDepth = 100'000;
+    auto nested = ReadFull(std::string(kDepth, '(') + std::string(kDepth, ')'));
+    REQUIRE(Is<Cell>(nested));
+}
+
+TEST_CASE("Parallel reader") {
+    std::string input;
+    std::vector<std::string> expected;
+    Interpreter interpreter;
+    for (int i = 0; i < 5000; ++i) {
+        std::string datum;
+        switch (i % 4) {
+            case 0:
+                datum = "(record " + std::to_string(i) + " (name x" + std::to_string(i) + ") #t)";
+                break;
+            case 1:
+                datum = "'(" + std::to_string(i) + " . tail)";
+                break;
+            case 2:
+                datum = "sym" + std::to_string(i);
+                break;
+            default:
+                datum = "' (nested (list (" + std::to_string(i) + ")))";
+        }
+        input += datum + (i % 3 ? " " : "\n  ");
+        expected.push_back(interpreter.PerformOutput(ReadFull(datum)));
+    }
+    for (size_t threads : {1, 2, 3, 8}) {
+        auto parsed = ReadParallel(input, threads);
+        REQUIRE(parsed.datums.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(interpreter.PerformOutput(parsed.datums[i]) == expected[i]);
+        }
+    }
+    REQUIRE(ReadParallel("", 4).datums.empty());
+    REQUIRE_THROWS_AS(ReadParallel(input + " (1 . 2 3) " + input, 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(input + ")", 4), SyntaxError);
+}
+
+TEST_CASE("Canonical encoding") {
+    using namespace std::string_literals;
+    Interpreter interpreter;
+    std::string encoded;
+    interpreter.SerializeCanonical(ReadFull("(foo -2 (#t . x) '(#f) ())"), encoded);
+    REQUIRE(encoded == "(3:fooi\xfe\xff\xff\xff(t.1:x)'(f)())"s);
+    REQUIRE(interpreter.PerformOutput(ReadCanonical(encoded)) ==
+            interpreter.PerformOutput(ReadFull("(foo -2 (#t . x) '(#f) ())")));
+
+    const char* kInputs[] = {"5", "foo", "#t", "'x", "()", "(1 2 . 3)", "(a 'b . 'c)",
+                             "(((1) 2) . (3 4))", "''(x y)", "(-2147483647 2147483647)"};
+    for (const char* input : kInputs) {
+        std::string bytes;
+        interpreter.SerializeCanonical(ReadFull(input), bytes);
+        std::string round_trip;
+        interpreter.SerializeCanonical(ReadCanonical(bytes), round_trip);
+        REQUIRE(round_trip == bytes);
+        REQUIRE(interpreter.PerformOutput(ReadCanonical(bytes)) ==
+                interpreter.PerformOutput(ReadFull(input)));
+    }
+
+    for (auto invalid : {""s, "("s, "(1:a"s, "i\x01\x02"s, "3:ab"s, "0:"s, "01:a"s, "1a"s,
+                         "(1:a . )"s, "1:a1:b"s, " 1:a"s, "x"s}) {
+        REQUIRE_THROWS_AS(ReadCanonical(invalid), SyntaxError);
+    }
+    std::string builtin;
+    REQUIRE_THROWS_AS(interpreter.SerializeCanonical(
+                              OperationsMap::Instantiate().GetOperation(
+                                      SymbolTable::Instantiate().Intern("car")->GetId()),
+                              builtin),
+                      RuntimeError);
+}
+
+// Writes the events of every datum back out as text.
+class EventPrinter : public DatumHandler {
+public:
+    void OnBeginList() override {
+        out += "( ";
+    }
+    void OnEndList() override {
+        out += ") ";
+    }
+    void OnDot() override {
+        out += ". ";
+    }
+    void OnQuote() override {
+        out += "' ";
+    }
+    void OnNumber(int value) override {
+        out += std::to_string(value) + ' ';
+    }
+    void OnSymbol(std::string_view name) override {
+        out += std::string(name) + ' ';
+    }
+    void OnBoolean(bool value) override {
+        out += value ? "#t " : "#f ";
+    }
+
+    std::string out;
+};
+
+std::string PrintEvents(const std::string& str) {
+    std::stringstream ss{str};
+    Tokenizer tokenizer{&ss};
+    EventPrinter printer;
+    ReadEvents(&tokenizer, &printer);
+    REQUIRE(tokenizer.IsEnd());
+    return printer.out;
+}
+
+TEST_CASE("Event reader") {
+    REQUIRE(PrintEvents("-5") == "-5 ");
+    REQUIRE(PrintEvents("(a '(1 . #t) () ((x)) . y)") ==
+            "( a ' ( 1 . #t ) ( ) ( ( x ) ) . y ) ");
+    REQUIRE(PrintEvents("''(1 2 . 3)") == "' ' ( 1 2 . 3 ) ");
+
+    size_t allocations = 0;
+    RunArena arena{&allocations};
+    std::stringstream input{"(1 (2 3)) foo '(4 . 5)"};
+    Tokenizer tokenizer{&input};
+    EventPrinter printer;
+    for (size_t datums = 1; datums <= 3; ++datums) {
+        ReadEvents(&tokenizer, &printer);
+        REQUIRE(tokenizer.IsEnd() == (datums == 3));
+    }
+    REQUIRE(printer.out == "( 1 ( 2 3 ) ) foo ' ( 4 . 5 ) ");
+    REQUIRE(allocations == 0);
+
+    for (const char* invalid : {"", "'", "(", "(1", "(1 .", "( .", "(1 . ()", "(1 . )",
+                                "(1 . 2 3)", ")", "(. 1)", "(1 . . 2)"}) {
+        REQUIRE_THROWS_AS(PrintEvents(invalid), SyntaxError);
+    }
+}
+
+TEST_CASE("Lazy reader") {
+    std::string source = "(a (b (c 1)) '(1 . 2) ( ) #t) x\n'(y (z))";
+    auto owner = std::make_shared<std::string>(source);
+    auto datums = ReadLazy(*owner, owner);
+    Interpreter interpreter;
+    REQUIRE(datums.size() == 3);
+    REQUIRE(interpreter.PerformOutput(datums[0]) ==
+            interpreter.PerformOutput(ReadFull("(a (b (c 1)) '(1 . 2) ( ) #t)")));
+    REQUIRE(interpreter.PerformOutput(datums[1]) == "x");
+    REQUIRE(interpreter.PerformOutput(datums[2]) ==
+            interpreter.PerformOutput(ReadFull("'(y (z))")));
+    REQUIRE(ReadLazy("", nullptr).empty());
+
+    // Only the brackets of a deferred list are checked until it is read.
+    auto broken = ReadLazy("(and #f (1 . . 2))", nullptr);
+    auto deferred = As<Cell>(As<Cell>(As<Cell>(broken[0])->GetSecond())->GetSecond())->GetFirst();
+    REQUIRE(Is<Cell>(deferred));
+    REQUIRE_THROWS_AS(As<Cell>(deferred)->GetFirst(), SyntaxError);
+    REQUIRE_THROWS_AS(ReadLazy("(a (b)", nullptr), SyntaxError);
+}
+
+TEST_CASE("Hash-consed quoted data") {
+    HashConsTable table;
+    std::string input = "(config '((tag 1 #t) (tag 1 #t) (tag 2 #t)) (tag 1 #t) '(tag 1 #t))";
+    Tokenizer tokenizer{std::string_view{input}};
+    auto config = Read(&tokenizer, &table);
+
+    auto element = [](Ref<Object> list, size_t index) {
+        for (size_t i = 0; i < index; ++i) {
+            list = As<Cell>(list)->GetSecond();
+        }
+        return As<Cell>(list)->GetFirst();
+    };
+    auto quoted = As<Cell>(element(config, 1))->GetSecond();
+    auto unquoted = element(config, 2);
+    auto last = As<Cell>(element(config, 3))->GetSecond();
+    REQUIRE(element(quoted, 0) == element(quoted, 1));
+    REQUIRE(element(quoted, 0) != element(quoted, 2));
+    REQUIRE(As<Cell>(element(quoted, 0))->GetSecond() != As<Cell>(element(quoted, 2))->GetSecond());
+    REQUIRE(As<Cell>(As<Cell>(element(quoted, 0))->GetSecond())->GetSecond() ==
+            As<Cell>(As<Cell>(element(quoted, 2))->GetSecond())->GetSecond());
+    REQUIRE(last == element(quoted, 0));
+    REQUIRE(unquoted != last);
+    // Three cells of the second (tag 1 #t), the (#t) of (tag 2 #t), three cells and the quote
+    // marker of the last quote.
+    REQUIRE(table.GetSharedObjectCount() == 8);
+    REQUIRE(table.GetSavedBytes() == 7 * sizeof(Cell) + sizeof(Quote));
+
+    // Lists outside quotes are read as usual.
+    REQUIRE(As<Cell>(config)->GetSegmentReach() == 3);
+}
+
+std::vector<Ref<Object>> TakeAll(IncrementalReader* reader) {
+    std::vector<Ref<Object>> datums;
+    while (reader->HasDatum()) {
+        datums.push_back(reader->TakeDatum());
+    }
+    return datums;
+}
+
+TEST_CASE("Incremental reader") {
+    SECTION("Datums are emitted as soon as they are complete") {
+        IncrementalReader reader;
+        reader.Feed("(1 (2");
+        REQUIRE(!reader.HasDatum());
+        reader.Feed(" 3)) '(4");
+        auto datums = TakeAll(&reader);
+        REQUIRE(datums.size() == 1);
+        REQUIRE(Is<Cell>(datums[0]));
+
+        reader.Feed(") 12");
+        REQUIRE(TakeAll(&reader).size() == 1);
+        reader.Feed("34");
+        REQUIRE(!reader.HasDatum());
+        reader.Feed("\n");
+        datums = TakeAll(&reader);
+        REQUIRE(datums.size() == 1);
+        REQUIRE(Number::GetValue(datums[0]) == 1234);
+
+        reader.Feed("foo");
+        reader.Finish();
+        datums = TakeAll(&reader);
+        REQUIRE(datums.size() == 1);
+        REQUIRE(As<Symbol>(datums[0])->GetName() == "foo");
+    }
+
+    SECTION("Byte-by-byte feeding matches reading the whole input") {
+        std::string input = "(+ 1 (* 2 -3)) #t '(a . b) (list 1 2 3) x";
+        IncrementalReader reader;
+        for (char symbol : input) {
+            reader.Feed(std::string_view{&symbol, 1});
+        }
+        reader.Finish();
+        auto datums = TakeAll(&reader);
+        REQUIRE(datums.size() == 5);
+        REQUIRE(As<Symbol>(datums[4])->GetName() == "x");
+        REQUIRE(Is<Boolean>(datums[1]));
+    }
+
+    SECTION("A large datum fed in small chunks") {
+        std::string input = "(";
+        for (int i = 0; i < 20'000; ++i) {
+            input += "(item-" + std::to_string(i) + " " + std::to_string(i * 7) + " #f) ";
+        }
+        input += "'(tail . 12345))";
+        Tokenizer tokenizer{std::string_view{input}};
+        auto expected = Interpreter{}.PerformOutput(Read(&tokenizer));
+        for (size_t chunk_size : {1, 7, 4096}) {
+            IncrementalReader reader;
+            bool is_early = false;
+            for (size_t i = 0; i < input.size(); i += chunk_size) {
+                is_early = is_early || reader.HasDatum();
+                reader.Feed(std::string_view{input}.substr(i, chunk_size));
+            }
+            REQUIRE(!is_early);
+            auto datums = TakeAll(&reader);
+            REQUIRE(datums.size() == 1);
+            REQUIRE(Interpreter{}.PerformOutput(datums[0]) == expected);
+        }
+    }
+
+    SECTION("Errors") {
+        IncrementalReader reader;
+        REQUIRE_THROWS_AS(reader.Feed(")"), SyntaxError);
+        REQUIRE_THROWS_AS(reader.Feed("(1 . )"), SyntaxError);
+        reader.Feed("(1 2");
+        REQUIRE_THROWS_AS(reader.Finish(), SyntaxError);
+        reader.Feed("(1 2)");
+        REQUIRE(TakeAll(&reader).size() == 1);
+        reader.Feed("(1 (2 . 3 4");
+        REQUIRE_THROWS_AS(reader.Feed(")"), SyntaxError);
+        reader.Feed("(a (b) . c");
+        REQUIRE_THROWS_AS(reader.Feed(" d)"), SyntaxError);
+        reader.Feed("'x");
+        reader.Finish();
+        REQUIRE(TakeAll(&reader).size() == 1);
+    }
+}
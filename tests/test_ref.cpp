@@ -0,0 +1,72 @@
+#include <catch.hpp>
+
+#include <collector.h>
+#include <scheme.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("References are counted in the object") {
+    auto cell = MakeObject<Cell>(MakeObject<Cell>(nullptr, nullptr), nullptr);
+    REQUIRE(cell.use_count() == 1);
+    REQUIRE(!cell->IsShared());
+    {
+        Ref<Object> copy = cell;
+        Ref<Object> other(cell.get());
+        REQUIRE(cell.use_count() == 3);
+        REQUIRE(copy == other);
+    }
+    REQUIRE(cell.use_count() == 1);
+
+    const auto& first = cell->GetFirst();
+    REQUIRE(first.use_count() == 1);
+    auto moved = std::move(cell);
+    REQUIRE(cell == nullptr);
+    REQUIRE(moved.use_count() == 1);
+    REQUIRE(StaticRefCast<Cell>(moved)->GetFirst() == first);
+}
+
+TEST_CASE("Constants are pinned or immediate") {
+    REQUIRE(SymbolTable::Instantiate().Intern("pinned-symbol")->IsShared());
+    // Numbers and booleans are held in the word of the Ref and are never counted.
+    auto number = Number::Make(1 << 30);
+    REQUIRE(IsImmediate(number.get()));
+    REQUIRE(number.use_count() == 0);
+    Ref<Object> copy = number;
+    REQUIRE(Number::GetValue(copy) == 1 << 30);
+    REQUIRE(IsImmediate(Boolean::Make(true).get()));
+}
+
+TEST_CASE("Objects shared across threads") {
+    CycleCollector collector{0};
+    Ref<Object> list;
+    for (int i = 0; i < 1000; ++i) {
+        list = MakeObject<Cell>(MakeObject<Cell>(nullptr, nullptr), std::move(list));
+    }
+    ShareAcrossThreads(list);
+    REQUIRE(collector.GetTrackedCount() == 0);
+
+    std::atomic<int> sum = 0;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([list, &sum] {
+                for (int pass = 0; pass < 100; ++pass) {
+                    for (auto rest = list; rest; rest = AsRef<Cell>(rest).GetSecond()) {
+                        auto first = AsRef<Cell>(rest).GetFirst();
+                        sum += first->IsShared();
+                    }
+                }
+            });
+        }
+    }
+    REQUIRE(sum == 4 * 100 * 1000);
+    // Each cell is held by its predecessor (or `list`) and by `rest`.
+    for (Ref<Object> rest = list; rest; rest = AsRef<Cell>(rest).GetSecond()) {
+        REQUIRE(rest.use_count() == 2);
+        REQUIRE(AsRef<Cell>(rest).GetFirst().use_count() == 1);
+    }
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(list? '(1 2 3))") == "#t");
+}
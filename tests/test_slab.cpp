@@ -0,0 +1,92 @@
+#include <catch.hpp>
+
+#include <slab.h>
+#include <scheme.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Slab blocks are recycled") {
+    void* first = SlabPool::Allocate(sizeof(Cell));
+    SlabPool::Deallocate(first, sizeof(Cell));
+    void* second = SlabPool::Allocate(sizeof(Cell));
+    REQUIRE(first == second);
+    SlabPool::Deallocate(second, sizeof(Cell));
+
+    // Sizes in the same class share blocks; other classes do not.
+    void* small = SlabPool::Allocate(SlabPool::kGranularity);
+    SlabPool::Deallocate(small, SlabPool::kGranularity);
+    REQUIRE(SlabPool::Allocate(SlabPool::kGranularity - 1) == small);
+    REQUIRE(SlabPool::Allocate(SlabPool::kMaxBlockSize) != small);
+}
+
+TEST_CASE("Slab blocks are aligned and distinct") {
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10'000; ++i) {
+        void* block = SlabPool::Allocate(48);
+        REQUIRE(reinterpret_cast<uintptr_t>(block) % SlabPool::kGranularity == 0);
+        blocks.push_back(block);
+    }
+    std::sort(blocks.begin(), blocks.end());
+    REQUIRE(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+    for (void* block : blocks) {
+        SlabPool::Deallocate(block, 48);
+    }
+}
+
+TEST_CASE("Objects cross threads") {
+    std::vector<Ref<Object>> chains(4);
+    {
+        std::vector<std::jthread> threads;
+        for (auto& chain : chains) {
+            threads.emplace_back([&chain] {
+                for (int i = 0; i < 1000; ++i) {
+                    chain = MakeObject<Cell>(Number::Make(i + 5000), std::move(chain));
+                }
+            });
+        }
+    }
+    // The chains were allocated by threads that have exited; free them here, then reuse the
+    // blocks from this thread.
+    for (const auto& chain : chains) {
+        REQUIRE(Number::GetValue(AsRef<Cell>(chain).GetFirst()) == 5999);
+    }
+    chains.clear();
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(list 5000 6000 7000)") == "(5000 6000 7000)");
+}
+
+TEST_CASE("Blocks freed on other threads return to the depot") {
+    // The reader thread of RunProgram allocates the forms and this thread frees them, so without
+    // returning them the blocks would pile up on this thread's lists.
+    std::string program;
+    for (int i = 0; i < 20'000; ++i) {
+        program += "(list? '((1) (2) (3)))\n";
+    }
+    Interpreter interpreter;
+    for (int run = 0; run < 3; ++run) {
+        interpreter.RunProgram(program);
+    }
+    size_t warm_bytes = SlabPool::GetSlabBytes();
+    for (int run = 0; run < 20; ++run) {
+        REQUIRE(interpreter.RunProgram(program).size() == 20'000);
+    }
+    REQUIRE(SlabPool::GetSlabBytes() <= warm_bytes + (1 << 20));
+
+    // A thread that only frees hands its blocks over when it exits.
+    warm_bytes = SlabPool::GetSlabBytes();
+    std::vector<void*> blocks(1000);
+    for (int run = 0; run < 200; ++run) {
+        for (void*& block : blocks) {
+            block = SlabPool::Allocate(sizeof(Cell));
+        }
+        std::jthread{[&blocks] {
+            for (void* block : blocks) {
+                SlabPool::Deallocate(block, sizeof(Cell));
+            }
+        }}.join();
+    }
+    REQUIRE(SlabPool::GetSlabBytes() <= warm_bytes + (1 << 20));
+}
@@ -2,7 +2,9 @@
 
 #include <error.h>
 #include <tokenizer.h>
+#include <structural_index.h>
 
+#include <random>
 #include <sstream>
 
 TEST_CASE("Tokenizer works on simple case") {
@@ -153,3 +155,109 @@ TEST_CASE("Empty string handled correctly") {
 
     REQUIRE(tokenizer.IsEnd());
 }
+
+TEST_CASE("Numbers out of range") {
+    std::stringstream ss{"99999999999"};
+    REQUIRE_THROWS_AS(Tokenizer{&ss}, SyntaxError);
+}
+
+TEST_CASE("Long runs of spaces") {
+    std::stringstream ss{std::string(1 << 20, ' ') + "4" + std::string(1 << 20, '\n')};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{4}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
+
+TEST_CASE("Tokenizer works on a contiguous buffer") {
+    std::string_view input = "(foo -12 #t . 'bar)";
+    Tokenizer tokenizer{input};
+
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::OPEN});
+
+    tokenizer.Next();
+    auto symbol = std::get<SymbolToken>(tokenizer.GetToken());
+    REQUIRE(symbol.name == "foo");
+    REQUIRE(symbol.name.data() == input.data() + 1);
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{-12}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BooleanToken{true}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{DotToken{}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{QuoteToken{}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"bar"}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::CLOSE});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
+
+std::string RandomSource(size_t size, std::mt19937* rng) {
+    static const std::string kAlphabet = "()'. \n\n    abc-+?#tf0123456789";
+    std::uniform_int_distribution<size_t> pick(0, kAlphabet.size() - 1);
+    std::string source;
+    for (size_t i = 0; i < size; ++i) {
+        source += kAlphabet[pick(*rng)];
+    }
+    return source;
+}
+
+TEST_CASE("Structural index") {
+    std::mt19937 rng{42};
+    for (size_t size : {0, 1, 63, 64, 65, 1000}) {
+        auto source = RandomSource(size, &rng);
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < source.size(); ++i) {
+            bool is_space = source[i] == ' ' || source[i] == '\n';
+            bool is_structural = std::string_view{"().'"}.find(source[i]) != std::string_view::npos;
+            bool after_boundary =
+                i == 0 || std::string_view{"().' \n"}.find(source[i - 1]) != std::string_view::npos;
+            if (!is_space && (is_structural || after_boundary)) {
+                expected.push_back(i);
+            }
+        }
+        REQUIRE(BuildStructuralIndex(source) == expected);
+
+        // The same offsets, a window at a time.
+        std::vector<uint32_t> windows;
+        std::vector<uint32_t> window;
+        for (size_t begin = 0; begin < source.size(); begin += 100) {
+            BuildStructuralIndex(source, begin, std::min(begin + 100, source.size()), window);
+            windows.insert(windows.end(), window.begin(), window.end());
+        }
+        REQUIRE(windows == expected);
+    }
+}
+
+TEST_CASE("Indexed tokenizer matches stream tokenizer") {
+    std::mt19937 rng{7};
+    static const char* kLexemes[] = {"(", ")", "'", ".", " ", "\n", "  ", "foo ", "a-b? ", "- ",
+                                     "+ ", "-12 ", "+7\n", "5-3 ", "#t ", "#f ", "1234 ", "<= "};
+    std::uniform_int_distribution<size_t> pick(0, std::size(kLexemes) - 1);
+    std::string source;
+    while (source.size() < 3 * Tokenizer::kStructuralIndexWindow) {
+        source += kLexemes[pick(rng)];
+    }
+    std::stringstream ss{source};
+    Tokenizer stream_tokenizer{&ss};
+    Tokenizer buffer_tokenizer{std::string_view{source}};
+    while (!stream_tokenizer.IsEnd()) {
+        REQUIRE(!buffer_tokenizer.IsEnd());
+        REQUIRE(stream_tokenizer.GetToken() == buffer_tokenizer.GetToken());
+        buffer_tokenizer.Next();
+        stream_tokenizer.Next();
+    }
+    REQUIRE(buffer_tokenizer.IsEnd());
+}
@@ -1,12 +1,70 @@
 #include <tokenizer.h>
+#include <structural_index.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+
+// Character classes of the lexer, one bit per class.
+enum CharClass : uint8_t {
+    kBeginSymbolClass = 1 << 0,
+    kInnerSymbolClass = 1 << 1,
+    kNumClass = 1 << 2,
+};
+
+constexpr std::array<uint8_t, 256> BuildCharClassTable() {
+    std::array<uint8_t, 256> table{};
+    auto mark = [&table](const char* chars, uint8_t char_class) {
+        for (; *chars; ++chars) {
+            table[static_cast<unsigned char>(*chars)] |= char_class;
+        }
+    };
+    auto mark_range = [&table](char from, char to, uint8_t char_class) {
+        for (int c = from; c <= to; ++c) {
+            table[c] |= char_class;
+        }
+    };
+    mark_range('a', 'z', kBeginSymbolClass | kInnerSymbolClass | kNumClass);
+    mark_range('A', 'Z', kBeginSymbolClass | kInnerSymbolClass | kNumClass);
+    mark_range('0', '9', kInnerSymbolClass | kNumClass);
+    mark("<=>*/#", kBeginSymbolClass | kInnerSymbolClass);
+    mark("?!-", kInnerSymbolClass);
+    return table;
+}
+
+static constexpr std::array<uint8_t, 256> kCharClassTable = BuildCharClassTable();
+
+static bool HasCharClass(char s, uint8_t char_class) {
+    return kCharClassTable[static_cast<unsigned char>(s)] & char_class;
+}
+
+static int ParseNum(std::string_view num) {
+    int value = 0;
+    auto [end, error] = std::from_chars(num.data(), num.data() + num.size(), value);
+    if (error != std::errc() || end == num.data()) {
+        throw SyntaxError("invalid number literal");
+    }
+    return value;
+}
+
+Tokenizer::Tokenizer(std::string_view input)
+    : tokenizer_(nullptr), input_(input), is_finished_stream_(false) {
+    if (input.size() >= kStructuralIndexThreshold &&
+        input.size() <= std::numeric_limits<uint32_t>::max()) {
+        is_indexed_ = true;
+    }
+    Next();
+}
 
 void Tokenizer::Next() {
     if (!is_finished_stream_) {
+        SkipSpaces();
         if (CheckEOF()) {
             is_finished_stream_ = true;
             return;
         }
-        char symbol = static_cast<char>(tokenizer_->get());
+        char symbol = static_cast<char>(Get());
         if (CheckPoint(symbol)) {
             CreateDotToken();
         } else if (CheckOpenBracket(symbol)) {
@@ -16,7 +74,7 @@ void Tokenizer::Next() {
         } else if (CheckQuote(symbol)) {
             CreateQuoteToken();
         } else if (CheckBeginSymbol(symbol)) {
-            std::string name = HandleSymbolSequence(symbol);
+            std::string_view name = HandleSymbolSequence(symbol);
             if (CheckBoolean(name)) {
                 CreateBooleanToken(name);
             } else {
@@ -25,10 +83,7 @@ void Tokenizer::Next() {
         } else if (CheckPlus(symbol) || CheckMinus(symbol)) {
             HandleUnarySign(symbol);
         } else if (CheckNum(symbol)) {
-            std::string number = CollectNum(symbol);
-            CreateConstantToken(std::stoi(number));
-        } else if (CheckSpace(symbol) || CheckNextLine(symbol)) {
-            Next();
+            CreateConstantToken(ParseNum(CollectNum(symbol)));
         } else {
             throw SyntaxError("error in tokenizer occurred");
         }
@@ -37,6 +92,80 @@ void Tokenizer::Next() {
     }
 }
 
+int Tokenizer::Peek() {
+    if (tokenizer_) {
+        return tokenizer_->peek();
+    }
+    return position_ < input_.size() ? static_cast<unsigned char>(input_[position_]) : EOF;
+}
+
+int Tokenizer::Get() {
+    if (tokenizer_) {
+        return tokenizer_->get();
+    }
+    return position_ < input_.size() ? static_cast<unsigned char>(input_[position_++]) : EOF;
+}
+
+void Tokenizer::SkipSpaces() {
+    if (is_indexed_) {
+        // A non-space byte here continues the run of the previous token (as in "5-3"),
+        // otherwise the next token starts at the next indexed offset.
+        if (position_ < input_.size() && !CheckSpace(input_[position_]) &&
+            !CheckNextLine(input_[position_])) {
+            return;
+        }
+        while (true) {
+            while (structural_cursor_ < structural_index_.size() &&
+                   structural_index_[structural_cursor_] < position_) {
+                ++structural_cursor_;
+            }
+            if (structural_cursor_ < structural_index_.size()) {
+                position_ = structural_index_[structural_cursor_];
+                return;
+            }
+            if (structural_window_end_ >= input_.size()) {
+                position_ = input_.size();
+                return;
+            }
+            // Indexes the next window, which starts at the current byte if a token or
+            // SkipList has run past the end of this one.
+            size_t begin = std::max(structural_window_end_, position_);
+            structural_window_end_ = std::min(begin + kStructuralIndexWindow, input_.size());
+            BuildStructuralIndex(input_, begin, structural_window_end_, structural_index_);
+            structural_cursor_ = 0;
+        }
+    }
+    while (!CheckEOF()) {
+        char symbol = static_cast<char>(Peek());
+        if (!CheckSpace(symbol) && !CheckNextLine(symbol)) {
+            break;
+        }
+        Get();
+    }
+}
+
+// In buffer mode a lexeme is a slice of the input, in stream mode it is accumulated in lexeme_.
+void Tokenizer::BeginLexeme(char symbol) {
+    if (tokenizer_) {
+        lexeme_.assign(1, symbol);
+    } else {
+        lexeme_begin_ = position_ - 1;
+    }
+}
+
+void Tokenizer::ExtendLexeme(char symbol) {
+    if (tokenizer_) {
+        lexeme_ += symbol;
+    }
+}
+
+std::string_view Tokenizer::GetLexeme() {
+    if (tokenizer_) {
+        return lexeme_;
+    }
+    return input_.substr(lexeme_begin_, position_ - lexeme_begin_);
+}
+
 bool Tokenizer::IsEnd() {
     return is_finished_stream_;
 }
@@ -45,11 +174,89 @@ Token Tokenizer::GetToken() {
     return last_token_;
 }
 
+TokenKind Tokenizer::GetKind() {
+    if (is_finished_stream_) {
+        return TokenKind::END;
+    }
+    if (std::holds_alternative<ConstantToken>(last_token_)) {
+        return TokenKind::CONSTANT;
+    }
+    if (std::holds_alternative<SymbolToken>(last_token_)) {
+        return TokenKind::SYMBOL;
+    }
+    if (std::holds_alternative<BracketToken>(last_token_)) {
+        return std::get<BracketToken>(last_token_) == BracketToken::OPEN ? TokenKind::OPEN
+                                                                        : TokenKind::CLOSE;
+    }
+    if (std::holds_alternative<QuoteToken>(last_token_)) {
+        return TokenKind::QUOTE;
+    }
+    if (std::holds_alternative<DotToken>(last_token_)) {
+        return TokenKind::DOT;
+    }
+    return TokenKind::BOOLEAN;
+}
+
+std::string_view Tokenizer::SkipList() {
+    if (tokenizer_ || GetKind() != TokenKind::OPEN) {
+        throw SyntaxError("error in parser occurred");
+    }
+    size_t begin = position_ - 1;
+    size_t depth = 1;
+    while (depth > 0) {
+        if (position_ == input_.size()) {
+            throw SyntaxError("error in parser occurred");
+        }
+        char symbol = input_[position_++];
+        if (CheckOpenBracket(symbol)) {
+            ++depth;
+        } else if (CheckCloseBracket(symbol)) {
+            --depth;
+        }
+    }
+    CreateCloseBracketToken();
+    return input_.substr(begin, position_ - begin);
+}
+
+TokenBuffer Tokenizer::TokenizeAll(std::string_view input) {
+    if (input.size() > std::numeric_limits<uint32_t>::max()) {
+        throw SyntaxError("input is too large");
+    }
+    TokenBuffer buffer{input, {}, {}, {}, {}};
+    size_t expected_tokens = input.size() / 4;
+    buffer.kinds.reserve(expected_tokens);
+    buffer.offsets.reserve(expected_tokens);
+    buffer.lengths.reserve(expected_tokens);
+    buffer.values.reserve(expected_tokens);
+    Tokenizer tokenizer{input};
+    while (!tokenizer.IsEnd()) {
+        TokenKind kind = tokenizer.GetKind();
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        int value = 0;
+        if (kind == TokenKind::SYMBOL) {
+            std::string_view name = std::get<SymbolToken>(tokenizer.last_token_).name;
+            offset = static_cast<uint32_t>(name.data() - input.data());
+            length = static_cast<uint32_t>(name.size());
+        } else if (kind == TokenKind::CONSTANT) {
+            value = std::get<ConstantToken>(tokenizer.last_token_).value;
+        } else if (kind == TokenKind::BOOLEAN) {
+            value = std::get<BooleanToken>(tokenizer.last_token_).value;
+        }
+        buffer.kinds.push_back(kind);
+        buffer.offsets.push_back(offset);
+        buffer.lengths.push_back(length);
+        buffer.values.push_back(value);
+        tokenizer.Next();
+    }
+    return buffer;
+}
+
 void Tokenizer::CreateConstantToken(int value) {
     last_token_ = ConstantToken{value};
 }
 
-void Tokenizer::CreateSymbolToken(std::string &name) {
+void Tokenizer::CreateSymbolToken(std::string_view name) {
     last_token_ = SymbolToken{name};
 }
 
@@ -69,7 +276,7 @@ void Tokenizer::CreateDotToken() {
     last_token_ = DotToken{};
 }
 
-void Tokenizer::CreateBooleanToken(std::string value) {
+void Tokenizer::CreateBooleanToken(std::string_view value) {
     if (value == "#f") {
         last_token_ = BooleanToken{false};
     } else {
@@ -78,21 +285,15 @@ void Tokenizer::CreateBooleanToken(std::string value) {
 }
 
 bool Tokenizer::CheckBeginSymbol(char s) {
-    static const auto kBeginningParser = std::regex("[a-zA-Z<=>*/#]");
-    std::string to_check;
-    to_check += s;
-    return std::regex_search(to_check.begin(), to_check.end(), kBeginningParser);
+    return HasCharClass(s, kBeginSymbolClass);
 }
 
 bool Tokenizer::CheckInnerSymbol(char s) {
-    static const auto kInParser = std::regex("[a-zA-Z<=>*/#0-9?!-]");
-    std::string to_check;
-    to_check += s;
-    return std::regex_search(to_check.begin(), to_check.end(), kInParser);
+    return HasCharClass(s, kInnerSymbolClass);
 }
 
 bool Tokenizer::CheckEOF() {
-    return tokenizer_->peek() == EOF;
+    return Peek() == EOF;
 }
 
 bool Tokenizer::CheckEOF(char s) {
@@ -100,7 +301,7 @@ bool Tokenizer::CheckEOF(char s) {
 }
 
 bool Tokenizer::CheckNum(char s) {
-    return std::isalnum(s);
+    return HasCharClass(s, kNumClass);
 }
 
 bool Tokenizer::CheckNextLine(char s) {
@@ -135,50 +336,37 @@ bool Tokenizer::CheckSpace(char s) {
     return s == Space;
 }
 
-bool Tokenizer::CheckBoolean(std::string &s) {
+bool Tokenizer::CheckBoolean(std::string_view s) {
     return s == "#f" || s == "#t";
 }
 
-std::string Tokenizer::CollectNum(char symbol) {
-    std::string num;
-    num += symbol;
-    while (!CheckEOF(symbol) && CheckNum(symbol)) {
-        if (CheckNum(tokenizer_->peek())) {
-            symbol = tokenizer_->get();
-            num += symbol;
-        } else {
-            break;
-        }
+std::string_view Tokenizer::CollectNum(char symbol) {
+    BeginLexeme(symbol);
+    while (CheckNum(static_cast<char>(Peek()))) {
+        ExtendLexeme(static_cast<char>(Get()));
     }
-    return num;
+    return GetLexeme();
 }
 
-std::string Tokenizer::HandleSymbolSequence(char symbol) {
-    std::string name;
-    while (!CheckEOF(symbol) && (CheckBeginSymbol(symbol) || CheckInnerSymbol(symbol))) {
-        name += symbol;
-        symbol = tokenizer_->peek();
-        if (!CheckBeginSymbol(symbol) && !CheckInnerSymbol(symbol)) {
-            break;
-        }
-        symbol = tokenizer_->get();
+std::string_view Tokenizer::HandleSymbolSequence(char symbol) {
+    BeginLexeme(symbol);
+    while (CheckInnerSymbol(static_cast<char>(Peek()))) {
+        ExtendLexeme(static_cast<char>(Get()));
     }
-    return name;
+    return GetLexeme();
 }
 
 void Tokenizer::HandleUnarySign(char symbol) {
-    char next_symbol;
-    next_symbol = tokenizer_->peek();
+    char next_symbol = static_cast<char>(Peek());
     if (!CheckEOF(next_symbol) && CheckNum(next_symbol)) {
-        next_symbol = tokenizer_->get();
-        int number = std::stoi(CollectNum(next_symbol));
+        next_symbol = static_cast<char>(Get());
+        int number = ParseNum(CollectNum(next_symbol));
         if (symbol == '-') {
             number *= -1;
         }
         CreateConstantToken(number);
     } else {
-        std::string name;
-        name += symbol;
-        CreateSymbolToken(name);
+        BeginLexeme(symbol);
+        CreateSymbolToken(GetLexeme());
     }
-}
\ No newline at end of file
+}
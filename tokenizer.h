@@ -1,13 +1,18 @@
 #pragma once
 
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include <istream>
-#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <error.h>
 
+// `name` refers either to the tokenizer input (buffer mode) or to the tokenizer's own lexeme
+// buffer (stream mode), so in stream mode it stays valid only until the next call of Next().
 struct SymbolToken {
-    std::string name;
+    std::string_view name;
 
     bool operator==(const SymbolToken& other) const {
         return name == other.name;
@@ -47,18 +52,57 @@ struct ConstantToken {
 using Token =
         std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken, BooleanToken>;
 
+enum class TokenKind : uint8_t { CONSTANT, OPEN, CLOSE, SYMBOL, QUOTE, DOT, BOOLEAN, END };
+
+// Whole input tokenized up front into parallel arrays, one entry per token. Symbols are stored
+// as a slice of `source`, constants and booleans as `values`; `source` must outlive the buffer.
+struct TokenBuffer {
+    std::string_view source;
+    std::vector<TokenKind> kinds;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<int> values;
+
+    size_t Size() const {
+        return kinds.size();
+    }
+
+    std::string_view GetName(size_t index) const {
+        return source.substr(offsets[index], lengths[index]);
+    }
+};
+
 class Tokenizer {
 public:
     Tokenizer(std::istream* in) : tokenizer_(in), is_finished_stream_(false) {
         Next();
     };
 
+    // Tokenizes a contiguous buffer in place; `input` must outlive the tokenizer and its tokens.
+    // Inputs of at least kStructuralIndexThreshold bytes are scanned into a structural index as
+    // the tokenizer advances, kStructuralIndexWindow bytes at a time, so the index stays small
+    // however long the input is.
+    Tokenizer(std::string_view input);
+
+    static constexpr size_t kStructuralIndexThreshold = 4096;
+    static constexpr size_t kStructuralIndexWindow = 16384;
+
     bool IsEnd();
 
     void Next();
 
     Token GetToken();
 
+    TokenKind GetKind();
+
+    // Buffer mode only, with an open bracket as the current token: skips to the matching close
+    // bracket by counting brackets alone, without tokenizing what is in between, and makes that
+    // close bracket the current token. Returns the skipped list, brackets included.
+    std::string_view SkipList();
+
+    // Tokenizes all of `input` in one pass; throws SyntaxError on the first invalid token.
+    static TokenBuffer TokenizeAll(std::string_view input);
+
 private:
     void CreateConstantToken(int value);
 
@@ -66,9 +110,9 @@ private:
 
     void CreateCloseBracketToken();
 
-    void CreateBooleanToken(std::string value);
+    void CreateBooleanToken(std::string_view value);
 
-    void CreateSymbolToken(std::string& name);
+    void CreateSymbolToken(std::string_view name);
 
     void CreateQuoteToken();
 
@@ -102,16 +146,37 @@ private:
 
     bool CheckCloseBracket(char s);
 
-    bool CheckBoolean(std::string& s);
+    bool CheckBoolean(std::string_view s);
+
+    int Peek();
+
+    int Get();
+
+    void SkipSpaces();
+
+    void BeginLexeme(char symbol);
+
+    void ExtendLexeme(char symbol);
+
+    std::string_view GetLexeme();
 
     void HandleUnarySign(char symbol);
 
-    std::string HandleSymbolSequence(char symbol);
+    std::string_view HandleSymbolSequence(char symbol);
 
-    std::string CollectNum(char symbol);
+    std::string_view CollectNum(char symbol);
 
 private:
     std::istream* tokenizer_;
+    std::string_view input_;
+    size_t position_ = 0;
+    size_t lexeme_begin_ = 0;
+    std::string lexeme_;
+    // Token starts in the window of the input ending at structural_window_end_.
+    std::vector<uint32_t> structural_index_;
+    size_t structural_cursor_ = 0;
+    size_t structural_window_end_ = 0;
+    bool is_indexed_ = false;
     Token last_token_;
     bool is_finished_stream_;
 